@@ -0,0 +1,314 @@
+// Headless physics and collision benchmarks. No window, no audio, no assets
+// beyond the level files and their terrain images, so it runs on a plain
+// build box:
+//
+//      Benchmark [bodies] [obstacles] [level files...]
+//
+// Defaults are 500 bodies, 2000 obstacles and the three shipped levels, read
+// relative to the project directory like config.txt does. Each level is
+// loaded through LevelData as the game loads it, so its terrain is
+// classified with its own surface colours. Each case runs for
+// at least a quarter of a second and reports ns per operation and operations
+// per second, one line per case, so runs can be diffed over time.
+//
+// Outside Visual Studio, from this directory:
+//
+//      g++ -std=c++20 -O2 -I../GameProject Benchmark.cpp ../GameProject/{Physics,Entity,EntityManager,EntityCommandBuffer,Broadphase,SpatialGrid,TerrainGrid,DistanceField,LevelGeometry,LevelData,MappedFile,ThreadPool,SpawnTable}.cpp -lsfml-graphics -lsfml-window -lsfml-system -pthread -o Benchmark
+
+#include "Physics.h"
+#include "Components.h"
+#include "Entity.h"
+#include "EntityManager.h"
+#include "Broadphase.h"
+#include "CollisionLayers.h"
+#include "SpatialGrid.h"
+#include "LevelGeometry.h"
+#include "LevelData.h"
+#include "SpawnTable.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr double    MinSeconds = 0.25;
+    constexpr float     BodySize = 64.f;        // same as a barrel
+    constexpr float     TickSeconds = 1.f / 60.f;
+
+    volatile size_t     sink = 0;               // results go here so nothing is optimised away
+
+
+    double seconds(Clock::time_point from, Clock::time_point to) {
+        return std::chrono::duration<double>(to - from).count();
+    }
+
+
+    void report(const char* name, double elapsed, double ops, size_t calls) {
+        ops = std::max(ops, 1.0);
+        std::printf("%-34s %12.1f ns/op %14.0f op/s %10zu calls\n", name, elapsed * 1e9 / ops, ops / elapsed, calls);
+    }
+
+
+    // Calls fn until MinSeconds have passed (after one warm-up call); each
+    // call counts as opsPerCall operations.
+    template<typename Fn>
+    void run(const char* name, size_t opsPerCall, Fn&& fn) {
+        fn();
+
+        size_t calls = 0;
+        double elapsed = 0.0;
+        auto start = Clock::now();
+        do {
+            fn();
+            ++calls;
+            elapsed = seconds(start, Clock::now());
+        } while (elapsed < MinSeconds);
+
+        report(name, elapsed, static_cast<double>(calls) * opsPerCall, calls);
+    }
+
+
+    // Square world holding the obstacles and bodies at roughly the density of
+    // the park level.
+    struct World {
+        float               size{ 0.f };
+        EntityManager       em;
+        EntityVec           bodies;
+        SpatialGrid         obstacleGrid;
+        Physics::AABBs      obstacleBoxes;
+        CollisionMatrix     matrix;
+        SortAndSweep        broadphase;
+
+        World(size_t bodyCount, size_t obstacleCount, std::mt19937& rng) {
+            size = std::sqrt(static_cast<float>(bodyCount + obstacleCount)) * 160.f + 1000.f;
+            std::uniform_real_distribution<float> pos(0.f, size);
+            std::uniform_real_distribution<float> vel(-200.f, 200.f);
+            std::uniform_int_distribution<int> len(1, 12);
+
+            std::vector<sf::FloatRect> rects;
+            rects.reserve(obstacleCount);
+            for (size_t i = 0; i < obstacleCount; ++i) {
+                bool across = (i % 2) == 0;
+                float w = across ? 16.f + 40.f * len(rng) : 16.f;
+                float h = across ? 16.f : 16.f + 40.f * len(rng);
+                rects.emplace_back(pos(rng), pos(rng), w, h);
+                obstacleBoxes.push(sf::Vector2f(rects.back().left + w / 2.f, rects.back().top + h / 2.f), sf::Vector2f(w / 2.f, h / 2.f));
+            }
+            obstacleGrid.build(rects);
+
+            em.reserve<CTransform, CBoundingBox, CRigidBody, CAwake>(Tags::Barrel, bodyCount);
+            for (size_t i = 0; i < bodyCount; ++i) {
+                auto e = em.addEntity(Tags::Barrel);
+                auto& tfm = e->addComponent<CTransform>(sf::Vector2f(pos(rng), pos(rng)));
+                tfm.vel = sf::Vector2f(vel(rng), vel(rng));
+                e->addComponent<CBoundingBox>(sf::Vector2f(BodySize, BodySize), CollisionLayer::Barrel);
+                e->addComponent<CRigidBody>(2.f, 0.4f, 0.f);
+                e->addComponent<CAwake>();
+            }
+            em.update();
+            for (auto [e, tfm] : em.view<CTransform>())
+                bodies.push_back(e);
+
+            matrix.set(CollisionLayer::Barrel, CollisionLayer::Barrel);
+        }
+
+        // integrate, bouncing off the edges so the density stays put
+        void integrate() {
+            for (auto [e, body, tfm] : em.view<CRigidBody, CTransform>()) {
+                tfm.prevPos = tfm.pos;
+                tfm.pos += tfm.vel * TickSeconds;
+                if (tfm.pos.x < 0.f || tfm.pos.x > size) tfm.vel.x = -tfm.vel.x;
+                if (tfm.pos.y < 0.f || tfm.pos.y > size) tfm.vel.y = -tfm.vel.y;
+            }
+        }
+
+        // narrowphase only: how many broadphase pairs really touch
+        size_t touching() const {
+            size_t n = 0;
+            for (auto [a, b] : broadphase.pairs()) {
+                auto overlap = Physics::getOverlap(a, b);
+                n += overlap.x > 0.f && overlap.y > 0.f;
+            }
+            return n;
+        }
+
+        size_t resolve() {
+            size_t resolved = 0;
+            for (auto [a, b] : broadphase.pairs())
+                resolved += Physics::resolveContact(a, b);
+            return resolved;
+        }
+    };
+
+
+    // The collision tick stage by stage, each timed on its own over the same
+    // ticks so the split adds up to the whole. Resolution has to run on fresh
+    // contacts every tick, which is why it can't be looped on its own.
+    void benchTick(World& world) {
+        double integrate = 0.0, broad = 0.0, narrow = 0.0, resolve = 0.0;
+        size_t ticks = 0, pairs = 0;
+
+        auto start = Clock::now();
+        do {
+            auto t0 = Clock::now();
+            world.integrate();
+            auto t1 = Clock::now();
+            world.broadphase.update(world.em, world.matrix);
+            auto t2 = Clock::now();
+            sink = sink + world.touching();
+            auto t3 = Clock::now();
+            sink = sink + world.resolve();
+            auto t4 = Clock::now();
+
+            integrate += seconds(t0, t1);
+            broad += seconds(t1, t2);
+            narrow += seconds(t2, t3);
+            resolve += seconds(t3, t4);
+            pairs += world.broadphase.pairs().size();
+            ++ticks;
+        } while (seconds(start, Clock::now()) < MinSeconds * 4);
+
+        double bodyOps = static_cast<double>(ticks) * world.bodies.size();
+        std::printf("   %.1f broadphase pairs per tick\n", static_cast<double>(pairs) / ticks);
+        report("tick: integrate (per body)", integrate, bodyOps, ticks);
+        report("tick: broadphase (per body)", broad, bodyOps, ticks);
+        report("tick: narrowphase (per pair)", narrow, static_cast<double>(pairs), ticks);
+        report("tick: resolve (per pair)", resolve, static_cast<double>(pairs), ticks);
+        report("tick: total (per tick)", integrate + broad + narrow + resolve, static_cast<double>(ticks), ticks);
+    }
+
+
+    void benchWorld(size_t bodyCount, size_t obstacleCount) {
+        std::mt19937 rng{ 1234 };
+        World world(bodyCount, obstacleCount, rng);
+        std::printf("-- %zu bodies, %zu obstacles, %.0fpx world\n", bodyCount, obstacleCount, world.size);
+
+        // narrowphase primitives
+        run("getOverlap", world.bodies.size(), [&] {
+            float sum = 0.f;
+            for (size_t i = 1; i < world.bodies.size(); ++i)
+                sum += Physics::getOverlap(world.bodies[i - 1], world.bodies[i]).x;
+            sink = sink + static_cast<size_t>(sum);
+            });
+
+        Physics::AABBs bodyBoxes;
+        for (auto e : world.bodies)
+            bodyBoxes.push(e->getComponent<CTransform>().pos, e->getComponent<CBoundingBox>().halfSize);
+        Physics::Overlaps overlaps;
+        sf::Vector2f probe(world.size / 2.f, world.size / 2.f);
+        run("overlapBatch (per box)", bodyBoxes.size(), [&] {
+            sink = sink + Physics::overlapBatch(probe, sf::Vector2f(BodySize, BodySize) / 2.f, bodyBoxes, overlaps);
+            });
+
+        run("sweep vs all obstacles (per box)", world.obstacleBoxes.size(), [&] {
+            sink = sink + Physics::sweep(probe, sf::Vector2f(16.f, 16.f), sf::Vector2f(300.f, 170.f), world.obstacleBoxes).index;
+            });
+
+        // obstacle grid, as the player's swept pass uses it
+        std::vector<sf::Vector2f> probes;
+        std::uniform_real_distribution<float> pos(0.f, world.size);
+        for (int i = 0; i < 1024; ++i)
+            probes.emplace_back(pos(rng), pos(rng));
+        std::vector<uint32_t> hits;
+        run("SpatialGrid::query 128px", probes.size(), [&] {
+            for (auto p : probes) {
+                hits.clear();
+                world.obstacleGrid.query(sf::FloatRect(p.x, p.y, 128.f, 128.f), hits);
+                sink = sink + hits.size();
+            }
+            });
+
+        std::vector<sf::FloatRect> rects;
+        for (size_t i = 0; i < world.obstacleBoxes.size(); ++i)
+            rects.emplace_back(world.obstacleBoxes.cx[i] - world.obstacleBoxes.hx[i], world.obstacleBoxes.cy[i] - world.obstacleBoxes.hy[i],
+                world.obstacleBoxes.hx[i] * 2.f, world.obstacleBoxes.hy[i] * 2.f);
+        SpatialGrid grid;
+        run("SpatialGrid::build (per box)", rects.size(), [&] {
+            grid.build(rects);
+            sink = sink + grid.size();
+            });
+
+        benchTick(world);
+    }
+
+
+    void benchLevel(const std::string& path) {
+        LevelData data;
+        auto compiledPath = "../cache/" + std::filesystem::path(path).stem().string() + ".level";
+        sf::Image image;
+        if (!data.load(path, compiledPath) || data.terrainPath.empty() || !image.loadFromFile(data.terrainPath)) {
+            std::printf("-- %s: could not load, skipped\n", path.c_str());
+            return;
+        }
+
+        const auto& colours = data.colours;
+        LevelGeometry level;
+        level.build(image, colours);
+        std::printf("-- %s (%s): %ux%u, %zu blocks merged into %zu obstacles, %zu spawn cells\n", path.c_str(),
+            data.terrainPath.c_str(), image.getSize().x, image.getSize().y, level.blockCount, level.obstacles.size(),
+            level.spawns.size());
+
+        run("LevelGeometry::build", 1, [&] { level.build(image, colours); });
+
+        TerrainGrid terrain;
+        run("TerrainGrid::build", 1, [&] { terrain.build(image, [&](sf::Color c) { return colours.classify(c); }); });
+
+        DistanceField field;
+        run("DistanceField::build", 1, [&] { field.build(level.terrain, Terrain::Wall); });
+
+        SpawnTable spawns;
+        run("SpawnTable::build", 1, [&] { spawns.build(level.terrain, Terrain::Track); });
+
+        std::mt19937 rng{ 99 };
+        std::vector<sf::Vector2f> points;
+        if (!spawns.empty()) {
+            run("SpawnTable::sample 200 (per point)", 200, [&] {
+                points.clear();
+                spawns.sample(200, 0.f, rng, points);
+                });
+            run("SpawnTable::sample 200, 64px apart", 200, [&] {
+                points.clear();
+                spawns.sample(200, 64.f, rng, points);
+                });
+        }
+
+        std::uniform_real_distribution<float> x(0.f, static_cast<float>(image.getSize().x));
+        std::uniform_real_distribution<float> y(0.f, static_cast<float>(image.getSize().y));
+        points.clear();
+        for (int i = 0; i < 4096; ++i)
+            points.emplace_back(x(rng), y(rng));
+        run("DistanceField::sample", points.size(), [&] {
+            float sum = 0.f;
+            for (auto p : points)
+                sum += level.wallField.sample(p).distance;
+            sink = sink + static_cast<size_t>(sum);
+            });
+    }
+}
+
+
+int main(int argc, char* argv[]) {
+    size_t bodies = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 500;
+    size_t obstacles = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000;
+
+    std::vector<std::string> levels;
+    for (int i = 3; i < argc; ++i)
+        levels.emplace_back(argv[i]);
+    if (levels.empty())
+        levels = { "../level1.txt", "../level2.txt", "../level3.txt" };
+
+    benchWorld(bodies, obstacles);
+    for (const auto& level : levels)
+        benchLevel(level);
+
+    return 0;
+}
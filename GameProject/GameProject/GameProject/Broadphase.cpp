@@ -0,0 +1,77 @@
+#include "Broadphase.h"
+#include "Entity.h"
+
+#include <algorithm>
+
+
+void SortAndSweep::update(EntityManager& em, const CollisionMatrix& matrix) {
+    auto isMember = [this](EntityPtr e) {
+        return e->getId() < _member.size() && _member[e->getId()] == e->getHandle().generation + 1;
+        };
+
+    // refresh the proxies that are still alive and still collide, drop the rest
+    auto end = std::remove_if(_proxies.begin(), _proxies.end(), [&](Proxy& p) {
+        auto e = em.get(p.handle);
+        if (!e || !e->hasComponent<CBoundingBox>() || !e->hasComponent<CTransform>() ||
+            !matrix.interactsWithAny(e->getComponent<CBoundingBox>().layer)) {
+            _member[p.handle.index] = 0;
+            return true;
+        }
+
+        auto& box = e->getComponent<CBoundingBox>();
+        auto& half = box.halfSize;
+        auto& pos = e->getComponent<CTransform>().pos;
+        p.layer = box.layer;
+        p.asleep = e->hasComponent<CRigidBody>() && !e->hasComponent<CAwake>();
+        p.minX = pos.x - half.x;
+        p.maxX = pos.x + half.x;
+        p.minY = pos.y - half.y;
+        p.maxY = pos.y + half.y;
+        return false;
+        });
+    _proxies.erase(end, _proxies.end());
+
+    // newcomers go on the end, the sort below moves them into place
+    for (auto [e, box, tfm] : em.view<CBoundingBox, CTransform>()) {
+        if (isMember(e) || !matrix.interactsWithAny(box.layer))
+            continue;
+
+        if (e->getId() >= _member.size())
+            _member.resize(e->getId() + 1, 0);
+        _member[e->getId()] = e->getHandle().generation + 1;
+
+        _proxies.push_back({ e, e->getHandle(),
+            tfm.pos.x - box.halfSize.x, tfm.pos.x + box.halfSize.x,
+            tfm.pos.y - box.halfSize.y, tfm.pos.y + box.halfSize.y, box.layer,
+            e->hasComponent<CRigidBody>() && !e->hasComponent<CAwake>() });
+    }
+
+    // insertion sort, cheap on last tick's nearly sorted order
+    for (size_t i = 1; i < _proxies.size(); ++i) {
+        auto p = _proxies[i];
+        size_t j = i;
+        for (; j > 0 && _proxies[j - 1].minX > p.minX; --j)
+            _proxies[j] = _proxies[j - 1];
+        _proxies[j] = p;
+    }
+
+    // sweep: everything starting before i ends is a candidate on x
+    _pairs.clear();
+    for (size_t i = 0; i < _proxies.size(); ++i) {
+        auto& a = _proxies[i];
+        for (size_t j = i + 1; j < _proxies.size() && _proxies[j].minX < a.maxX; ++j) {
+            auto& b = _proxies[j];
+            if (a.asleep && b.asleep)
+                continue;
+            if (a.minY < b.maxY && b.minY < a.maxY && matrix.interacts(a.layer, b.layer))
+                _pairs.emplace_back(a.e, b.e);
+        }
+    }
+}
+
+
+void SortAndSweep::clear() {
+    _proxies.clear();
+    _member.clear();
+    _pairs.clear();
+}
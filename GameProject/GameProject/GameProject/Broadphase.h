@@ -0,0 +1,56 @@
+#ifndef BREAKOUT_BROADPHASE_H
+#define BREAKOUT_BROADPHASE_H
+
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+#include "EntityManager.h"
+#include "CollisionLayers.h"
+
+
+// Sort-and-sweep over every entity with a CBoundingBox and a CTransform whose
+// layer interacts with something. Pairs of layers the matrix keeps apart are
+// never reported.
+//
+// The proxies stay sorted by their left edge from one tick to the next, so
+// after refreshing the bounds an insertion sort only has to fix the few that
+// moved past a neighbour, close to O(n) for things that move a little per
+// tick. The sweep then only compares proxies whose x ranges overlap.
+//
+// Sleeping rigid bodies keep their proxy so whatever runs into them is still
+// reported, but two sleepers are never paired: nothing between them changed.
+class SortAndSweep {
+public:
+    using Pair = std::pair<EntityPtr, EntityPtr>;
+
+private:
+    struct Proxy {
+        EntityPtr       e;
+        EntityHandle    handle;
+        float           minX, maxX;
+        float           minY, maxY;
+        CollisionLayer  layer;
+        bool            asleep;         // rigid body without CAwake
+    };
+
+    std::vector<Proxy>      _proxies;       // sorted by minX
+    std::vector<uint32_t>   _member;        // per entity index: generation + 1 while it has a proxy, else 0
+    std::vector<Pair>       _pairs;
+
+public:
+    // sync proxies with the live entities, re-sort and rebuild the pair list
+    void                        update(EntityManager& em, const CollisionMatrix& matrix);
+
+    // drop every proxy, for when the world is replaced wholesale (snapshot restore)
+    void                        clear();
+
+    // Boxes that overlap, as of the last update. Each pair appears once and
+    // the one further left comes first.
+    inline const std::vector<Pair>& pairs() const { return _pairs; }
+    inline size_t               size() const { return _proxies.size(); }
+};
+
+
+#endif //BREAKOUT_BROADPHASE_H
@@ -0,0 +1,63 @@
+#ifndef BREAKOUT_COLLISIONLAYERS_H
+#define BREAKOUT_COLLISIONLAYERS_H
+
+
+#include <array>
+#include <cstdint>
+
+
+enum class CollisionLayer : uint8_t {
+    Player,
+    Racer,
+    Barrel,
+    Pickup,
+    Wall,       // static level geometry, not an entity
+    Trigger,
+    Count
+};
+
+
+// Which layers interact, and which of them are solid. Two layers that don't
+// interact never even become a broadphase pair. A pair where either side is
+// not solid (pickups, triggers) is only reported, never pushed apart.
+class CollisionMatrix {
+private:
+    static constexpr size_t             LayerCount = static_cast<size_t>(CollisionLayer::Count);
+
+    std::array<uint32_t, LayerCount>    _masks{};
+    uint32_t                            _solid{ ~0u };
+
+    static constexpr uint32_t bit(CollisionLayer l) { return 1u << static_cast<uint32_t>(l); }
+    static constexpr size_t   idx(CollisionLayer l) { return static_cast<size_t>(l); }
+
+public:
+    // symmetric, a vs b is the same as b vs a
+    inline void set(CollisionLayer a, CollisionLayer b, bool interact = true) {
+        if (interact) {
+            _masks[idx(a)] |= bit(b);
+            _masks[idx(b)] |= bit(a);
+        }
+        else {
+            _masks[idx(a)] &= ~bit(b);
+            _masks[idx(b)] &= ~bit(a);
+        }
+    }
+
+
+    inline void setSolid(CollisionLayer l, bool solid) {
+        _solid = solid ? (_solid | bit(l)) : (_solid & ~bit(l));
+    }
+
+
+    inline bool interacts(CollisionLayer a, CollisionLayer b) const { return (_masks[idx(a)] & bit(b)) != 0; }
+    inline bool interactsWithAny(CollisionLayer l) const { return _masks[idx(l)] != 0; }
+    inline bool isSolid(CollisionLayer l) const { return (_solid & bit(l)) != 0; }
+
+    // interact and both solid: the two must be kept apart
+    inline bool blocks(CollisionLayer a, CollisionLayer b) const {
+        return interacts(a, b) && isSolid(a) && isSolid(b);
+    }
+};
+
+
+#endif //BREAKOUT_COLLISIONLAYERS_H
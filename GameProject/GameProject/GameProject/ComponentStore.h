@@ -0,0 +1,282 @@
+#ifndef BREAKOUT_COMPONENTSTORE_H
+#define BREAKOUT_COMPONENTSTORE_H
+
+
+#include <vector>
+#include <tuple>
+#include <limits>
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+
+#include "Components.h"
+
+// forward declarations
+class Entity;
+
+
+// one bit per component type, set while the entity owns that component
+using Signature = uint32_t;
+
+
+// Dense storage for a single component type.
+// _sparse maps an entity id to its slot in the dense arrays, so lookup, insert
+// and remove are O(1) and systems can walk the packed _dense array linearly.
+template<typename T>
+class SparseSet {
+public:
+    using value_type = T;
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+private:
+    std::vector<size_t>     _sparse;        // entity id -> dense index (npos if absent)
+    std::vector<T>          _dense;         // packed components
+    std::vector<size_t>     _ids;           // entity id of _dense[i]
+    std::vector<Entity*>    _owners;        // owner of _dense[i]
+
+public:
+    inline bool has(size_t id) const {
+        return id < _sparse.size() && _sparse[id] != npos;
+    }
+
+
+    template<typename... TArgs>
+    inline T& emplace(size_t id, Entity* owner, TArgs &&... mArgs) {
+        if (has(id)) {
+            auto& component = _dense[_sparse[id]];
+            component = T(std::forward<TArgs>(mArgs)...);
+            return component;
+        }
+
+        if (id >= _sparse.size())
+            _sparse.resize(id + 1, npos);
+
+        _sparse[id] = _dense.size();
+        _dense.emplace_back(std::forward<TArgs>(mArgs)...);
+        _ids.push_back(id);
+        _owners.push_back(owner);
+        return _dense.back();
+    }
+
+
+    // room for n more components, and sparse entries for ids below maxId
+    inline void reserve(size_t n, size_t maxId) {
+        _dense.reserve(_dense.size() + n);
+        _ids.reserve(_ids.size() + n);
+        _owners.reserve(_owners.size() + n);
+        if (_sparse.size() < maxId)
+            _sparse.resize(maxId, npos);
+    }
+
+
+    // swap-and-pop so the dense array stays packed
+    inline bool remove(size_t id) {
+        if (!has(id))
+            return false;
+
+        size_t idx = _sparse[id];
+        size_t last = _dense.size() - 1;
+        if (idx != last) {
+            _dense[idx] = std::move(_dense[last]);
+            _ids[idx] = _ids[last];
+            _owners[idx] = _owners[last];
+            _sparse[_ids[idx]] = idx;
+        }
+        _dense.pop_back();
+        _ids.pop_back();
+        _owners.pop_back();
+        _sparse[id] = npos;
+        return true;
+    }
+
+
+    inline T& get(size_t id) {
+        assert(has(id));
+        return _dense[_sparse[id]];
+    }
+
+
+    inline const T& get(size_t id) const {
+        assert(has(id));
+        return _dense[_sparse[id]];
+    }
+
+
+    inline T* tryGet(size_t id) {
+        return has(id) ? &_dense[_sparse[id]] : nullptr;
+    }
+
+
+    inline size_t                       size() const { return _dense.size(); }
+    inline bool                         empty() const { return _dense.empty(); }
+    inline T&                           operator[](size_t i) { return _dense[i]; }
+    inline size_t                       id(size_t i) const { return _ids[i]; }
+    inline Entity*                      owner(size_t i) const { return _owners[i]; }
+    inline const std::vector<Entity*>&  owners() const { return _owners; }
+
+    inline auto begin() { return _dense.begin(); }
+    inline auto end() { return _dense.end(); }
+    inline auto begin() const { return _dense.begin(); }
+    inline auto end() const { return _dense.end(); }
+
+
+    // Owners are stored as raw pointers, which is fine because an EntityManager
+    // never frees or moves an Entity. Archive is a Snapshot.
+    template<typename Archive>
+    inline void save(Archive& ar) const {
+        ar.writeArray(_sparse);
+        ar.writeArray(_ids);
+        ar.writeArray(_owners);
+        if constexpr (std::is_trivially_copyable_v<T>)
+            ar.writeArray(_dense);
+        else
+            ar.template shelf<T>() = _dense;
+    }
+
+
+    template<typename Archive>
+    inline void load(Archive& ar) {
+        ar.readArray(_sparse);
+        ar.readArray(_ids);
+        ar.readArray(_owners);
+        if constexpr (std::is_trivially_copyable_v<T>)
+            ar.readArray(_dense);
+        else
+            _dense = ar.template shelf<T>();
+    }
+};
+
+
+// one SparseSet per component type
+template<typename... Ts>
+class ComponentStore {
+private:
+    std::tuple<SparseSet<Ts>...>    _sets;
+
+    static_assert(sizeof...(Ts) <= sizeof(Signature) * 8, "too many component types for Signature");
+
+public:
+    // snapshot storage for the types SparseSet::save can't copy as bytes
+    using Shelves = std::tuple<std::vector<Ts>...>;
+
+    template<typename T>
+    static constexpr size_t indexOf() {
+        static_assert((std::is_same_v<T, Ts> || ...), "not a registered component type");
+        size_t i = 0;
+        size_t found = 0;
+        ((std::is_same_v<T, Ts> ? found = i++ : i++), ...);
+        return found;
+    }
+
+
+    template<typename... Us>
+    static constexpr Signature maskOf() {
+        return ((Signature(1) << indexOf<Us>()) | ... | Signature(0));
+    }
+
+
+    template<typename T>
+    inline SparseSet<T>& getSet() {
+        return std::get<SparseSet<T>>(_sets);
+    }
+
+
+    template<typename T>
+    inline const SparseSet<T>& getSet() const {
+        return std::get<SparseSet<T>>(_sets);
+    }
+
+
+    // drop every component owned by id, only touching the sets named in sig
+    inline void removeAll(size_t id, Signature sig) {
+        std::apply([id, sig](auto&... set) {
+            ((sig & maskOf<typename std::remove_reference_t<decltype(set)>::value_type>() ? (void)set.remove(id) : (void)0), ...);
+            }, _sets);
+    }
+
+
+    template<typename Archive>
+    inline void save(Archive& ar) const {
+        std::apply([&ar](const auto&... set) { (set.save(ar), ...); }, _sets);
+    }
+
+
+    template<typename Archive>
+    inline void load(Archive& ar) {
+        std::apply([&ar](auto&... set) { (set.load(ar), ...); }, _sets);
+    }
+};
+
+
+using Components = ComponentStore<CAnimation, CSprite, CHealth, CState, CTransform, CBoundingBox, CInput, CScore, CGun, CMissiles, CCollision, CSpin, CRigidBody, CAwake>;
+
+
+// Entities owning all of Lead, Rest...
+// Walks Lead's dense array and keeps the entries whose signature contains the
+// whole mask, so put the rarest component first. Lead is read straight from
+// the dense array, Rest through a sparse lookup.
+//
+//      for (auto [e, tfm, sprite] : _entityManager.view<CTransform, CSprite>())
+//      for (auto [e, tfm] : _entityManager.view<CTransform>().without<CRigidBody>())
+//
+template<typename Lead, typename... Rest>
+class View {
+private:
+    SparseSet<Lead>*                    _lead;
+    std::tuple<SparseSet<Rest>*...>     _rest;
+    const std::vector<Signature>*       _signatures;
+    Signature                           _mask;
+    Signature                           _exclude{ 0 };
+
+    inline bool matches(size_t i) const {
+        auto sig = (*_signatures)[_lead->id(i)];
+        return (sig & _mask) == _mask && (sig & _exclude) == 0;
+    }
+
+public:
+    using value_type = std::tuple<Entity*, Lead&, Rest&...>;
+
+    View(const std::vector<Signature>& signatures, SparseSet<Lead>& lead, SparseSet<Rest>&... rest)
+        : _lead(&lead), _rest(&rest...), _signatures(&signatures),
+        _mask(Components::maskOf<Lead, Rest...>()) {}
+
+
+    class Iterator {
+    private:
+        const View*     _view;
+        size_t          _i;
+
+        inline void skip() {
+            while (_i < _view->_lead->size() && !_view->matches(_i))
+                ++_i;
+        }
+
+    public:
+        Iterator(const View* view, size_t i) : _view(view), _i(i) { skip(); }
+
+        inline value_type operator*() const {
+            auto id = _view->_lead->id(_i);
+            return value_type(_view->_lead->owner(_i), (*_view->_lead)[_i],
+                std::get<SparseSet<Rest>*>(_view->_rest)->get(id)...);
+        }
+
+        inline Iterator& operator++() { ++_i; skip(); return *this; }
+        inline bool operator!=(const Iterator& other) const { return _i != other._i; }
+    };
+
+
+    // same view, skipping entities that own any of Ts...
+    template<typename... Ts>
+    inline View without() const {
+        View v = *this;
+        v._exclude |= Components::maskOf<Ts...>();
+        return v;
+    }
+
+
+    inline Iterator begin() const { return Iterator(this, 0); }
+    inline Iterator end() const { return Iterator(this, _lead->size()); }
+};
+
+
+#endif //BREAKOUT_COMPONENTSTORE_H
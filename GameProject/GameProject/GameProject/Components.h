@@ -10,11 +10,13 @@
 #include <memory>
 #include <SFML/Graphics.hpp>
 #include "Utilities.h"
+#include "CollisionLayers.h"
 
 
+// Ownership is tracked by the entity's Signature in EntityManager, so the
+// base carries no state and adds nothing to the size of a component.
 struct Component
 {
-    bool		has{ false };
     Component() = default;
 };
 
@@ -34,25 +36,52 @@ struct CSprite : public Component {
 
 
 
+// Hot per-tick data only, 28 bytes so a cache line holds two. Anything the
+// movement and collision passes don't touch every tick belongs elsewhere.
 struct CTransform : public Component
 {
-
-    sf::Transformable   tfm;
     sf::Vector2f	    pos{ 0.f, 0.f };
     sf::Vector2f	    prevPos{ 0.f, 0.f };
     sf::Vector2f	    vel{ 0.f, 0.f };
-    sf::Vector2f	    scale{ 1.f, 1.f };
-
-    float   angVel{ 0 };
-    float	angle{ 0.f };
+    float	            angle{ 0.f };
 
     CTransform() = default;
-    CTransform(const sf::Vector2f& p) : pos(p) {}
+    CTransform(const sf::Vector2f& p) : pos(p), prevPos(p) {}
     CTransform(const sf::Vector2f& p, const sf::Vector2f& v)
         : pos(p), prevPos(p), vel(v) {}
 
 };
 
+// rotation speed, only for the few entities that spin
+struct CSpin : public Component
+{
+    float   angVel{ 0.f };
+
+    CSpin() = default;
+    CSpin(float w) : angVel(w) {}
+};
+
+// Pushable body, moved by impulses. Entities without one are moved by their
+// own logic (input, scripted velocity) and count as infinitely heavy.
+struct CRigidBody : public Component
+{
+    float   invMass{ 1.f };         // 0 = immovable
+    float   restitution{ 0.3f };    // bounciness of its impacts
+    float   damping{ 3.f };         // share of its velocity lost per second
+    float   restTime{ 0.f };        // how long it has been nearly still
+
+    CRigidBody() = default;
+    CRigidBody(float mass, float e = 0.3f, float d = 3.f)
+        : invMass(mass > 0.f ? 1.f / mass : 0.f), restitution(e), damping(d) {}
+};
+
+// A rigid body that is moving. Sleeping bodies don't have one, so the
+// integration pass, which leads with this, never visits them.
+struct CAwake : public Component
+{
+    CAwake() = default;
+};
+
 struct CMissiles : public Component {
     size_t      missileCount{ 15 };
 
@@ -105,11 +134,13 @@ struct CBoundingBox : public Component
 {
     sf::Vector2f size{ 0.f, 0.f };
     sf::Vector2f halfSize{ 0.f, 0.f };
+    CollisionLayer layer{ CollisionLayer::Racer };
 
  
 
     CBoundingBox() = default;
-    CBoundingBox(const sf::Vector2f& s) : size(s), halfSize(0.5f * s)
+    CBoundingBox(const sf::Vector2f& s, CollisionLayer l = CollisionLayer::Racer)
+        : size(s), halfSize(0.5f * s), layer(l)
     {}
 
     CBoundingBox(float w, float h) : size(sf::Vector2f(w, h)), halfSize(0.5f * size)
@@ -147,11 +178,21 @@ struct CHealth : public Component {
 };
 
 
+enum class State : uint8_t {
+    None,
+    Straight,
+    Left,
+    Right,
+    Up,
+    Down,
+    Dead,
+};
+
 struct CState : public Component {
-    std::string state{ "none" };
+    State state{ State::None };
 
     CState() = default;
-    CState(const std::string& s) : state(s) {}
+    CState(State s) : state(s) {}
 };
 
 #endif //BREAKOUT_COMPONENTS_H
\ No newline at end of file
@@ -0,0 +1,162 @@
+#include "DistanceField.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+namespace {
+    constexpr float Far = 1e20f;        // "no seed here", finite so the envelope maths stays NaN-free
+
+
+    // Squared distance transform of one row/column (Felzenszwalb & Huttenlocher):
+    // d[q] = min over p of (q - p)^2 + f[p], using the lower envelope of parabolas.
+    void transform1d(const float* f, float* d, int n, int* v, float* z) {
+        int k = 0;
+        v[0] = 0;
+        z[0] = -std::numeric_limits<float>::infinity();
+        z[1] = std::numeric_limits<float>::infinity();
+
+        auto meet = [f](int q, int p) {
+            return ((f[q] + float(q) * q) - (f[p] + float(p) * p)) / (2.f * (q - p));
+            };
+
+        // z[0] is -inf, so k never drops below 0
+        for (int q = 1; q < n; ++q) {
+            float s = meet(q, v[k]);
+            while (s <= z[k]) {
+                --k;
+                s = meet(q, v[k]);
+            }
+            ++k;
+            v[k] = q;
+            z[k] = s;
+            z[k + 1] = std::numeric_limits<float>::infinity();
+        }
+
+        k = 0;
+        for (int q = 0; q < n; ++q) {
+            while (z[k + 1] < q)
+                ++k;
+            float dq = float(q - v[k]);
+            d[q] = dq * dq + f[v[k]];
+        }
+    }
+
+
+    // Squared distance, in cells, from every cell to the nearest seed. Each
+    // pass is independent per column (then per row), so bands of them run in
+    // parallel, each with its own scratch.
+    std::vector<float> transform2d(const std::vector<uint8_t>& seed, int cols, int rows) {
+        std::vector<float> grid(seed.size());
+        for (size_t i = 0; i < seed.size(); ++i)
+            grid[i] = seed[i] ? 0.f : Far;
+
+        int n = std::max(cols, rows);
+        auto& pool = ThreadPool::getInstance();
+
+        pool.parallelFor(cols, pool.bandGrain(cols), [&](size_t first, size_t last) {
+            std::vector<float> f(n), d(n), z(n + 1);
+            std::vector<int> v(n);
+            for (auto x = static_cast<int>(first); x < static_cast<int>(last); ++x) {
+                for (int y = 0; y < rows; ++y)
+                    f[y] = grid[y * cols + x];
+                transform1d(f.data(), d.data(), rows, v.data(), z.data());
+                for (int y = 0; y < rows; ++y)
+                    grid[y * cols + x] = d[y];
+            }
+            });
+
+        pool.parallelFor(rows, pool.bandGrain(rows), [&](size_t first, size_t last) {
+            std::vector<float> d(n), z(n + 1);
+            std::vector<int> v(n);
+            for (auto y = static_cast<int>(first); y < static_cast<int>(last); ++y) {
+                transform1d(&grid[y * cols], d.data(), cols, v.data(), z.data());
+                std::copy(d.begin(), d.begin() + cols, grid.begin() + y * cols);
+            }
+            });
+        return grid;
+    }
+}
+
+
+void DistanceField::build(const TerrainGrid& terrain, Terrain solid) {
+    _cellSize = static_cast<float>(terrain.cellSize());
+    _cols = static_cast<int>(terrain.size().x);
+    _rows = static_cast<int>(terrain.size().y);
+    _texels.clear();
+    if (_cols == 0 || _rows == 0)
+        return;
+
+    // bytes rather than vector<bool>, so bands can write neighbouring cells
+    std::vector<uint8_t> inside(static_cast<size_t>(_cols) * _rows);
+    std::vector<uint8_t> outside(inside.size());
+    for (int y = 0; y < _rows; ++y) {
+        for (int x = 0; x < _cols; ++x) {
+            bool s = terrain.cell(x, y) == solid;
+            inside[y * _cols + x] = s;
+            outside[y * _cols + x] = !s;
+        }
+    }
+
+    // distance to the nearest solid cell for open cells, to the nearest open
+    // cell for solid ones; the boundary sits half a cell from either centre
+    auto toSolid = transform2d(inside, _cols, _rows);
+    auto toOpen = transform2d(outside, _cols, _rows);
+
+    _texels.resize(inside.size());
+    for (size_t i = 0; i < _texels.size(); ++i) {
+        float d = inside[i] ? -(std::sqrt(toOpen[i]) - 0.5f) : std::sqrt(toSolid[i]) - 0.5f;
+        _texels[i] = { d * _cellSize, 0.f, 0.f };
+    }
+
+    // central differences, one-sided at the edges; rows only read distances
+    auto& pool = ThreadPool::getInstance();
+    pool.parallelFor(_rows, pool.bandGrain(_rows), [this](size_t first, size_t last) {
+        for (auto y = static_cast<int>(first); y < static_cast<int>(last); ++y) {
+            for (int x = 0; x < _cols; ++x) {
+                int x0 = std::max(x - 1, 0), x1 = std::min(x + 1, _cols - 1);
+                int y0 = std::max(y - 1, 0), y1 = std::min(y + 1, _rows - 1);
+                float gx = (x1 > x0) ? (_texels[y * _cols + x1].d - _texels[y * _cols + x0].d) / (x1 - x0) : 0.f;
+                float gy = (y1 > y0) ? (_texels[y1 * _cols + x].d - _texels[y0 * _cols + x].d) / (y1 - y0) : 0.f;
+                float len = std::hypot(gx, gy);
+                auto& t = _texels[y * _cols + x];
+                t.gx = len > 0.f ? gx / len : 0.f;
+                t.gy = len > 0.f ? gy / len : 0.f;
+            }
+        }
+        });
+}
+
+
+DistanceField::Sample DistanceField::sample(sf::Vector2f p) const {
+    if (_texels.empty())
+        return { std::numeric_limits<float>::max(), { 0.f, 0.f } };
+
+    // texel centres sit at (i + 0.5) * cellSize
+    float u = std::clamp(p.x / _cellSize - 0.5f, 0.f, static_cast<float>(_cols - 1));
+    float v = std::clamp(p.y / _cellSize - 0.5f, 0.f, static_cast<float>(_rows - 1));
+    int x0 = static_cast<int>(u), y0 = static_cast<int>(v);
+    int x1 = std::min(x0 + 1, _cols - 1), y1 = std::min(y0 + 1, _rows - 1);
+    float fx = u - x0, fy = v - y0;
+
+    auto& a = _texels[y0 * _cols + x0];
+    auto& b = _texels[y0 * _cols + x1];
+    auto& c = _texels[y1 * _cols + x0];
+    auto& d = _texels[y1 * _cols + x1];
+
+    auto lerp2 = [fx, fy](float ta, float tb, float tc, float td) {
+        float top = ta + (tb - ta) * fx;
+        float bottom = tc + (td - tc) * fx;
+        return top + (bottom - top) * fy;
+        };
+
+    Sample s;
+    s.distance = lerp2(a.d, b.d, c.d, d.d);
+    sf::Vector2f g(lerp2(a.gx, b.gx, c.gx, d.gx), lerp2(a.gy, b.gy, c.gy, d.gy));
+    float len = std::hypot(g.x, g.y);
+    if (len > 0.f)
+        s.normal = g / len;
+    return s;
+}
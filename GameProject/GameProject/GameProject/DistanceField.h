@@ -0,0 +1,75 @@
+#ifndef BREAKOUT_DISTANCEFIELD_H
+#define BREAKOUT_DISTANCEFIELD_H
+
+
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "TerrainGrid.h"
+
+
+// Signed distance, in world pixels, from the nearest boundary of one terrain
+// type: positive outside it, negative inside. Built once per level from a
+// TerrainGrid, with one sample at the centre of every terrain cell. The
+// gradient is stored next to the distance, so a lookup is a single bilinear
+// fetch of four samples.
+class DistanceField {
+public:
+    struct Sample {
+        float           distance{ 0.f };
+        sf::Vector2f    normal{ 0.f, 0.f };     // unit gradient, points away from the boundary
+    };
+
+private:
+    struct Texel {
+        float   d;
+        float   gx;
+        float   gy;
+    };
+
+    float                   _cellSize{ 4.f };
+    int                     _cols{ 0 };
+    int                     _rows{ 0 };
+    std::vector<Texel>      _texels;
+
+public:
+    DistanceField() = default;
+
+    void            build(const TerrainGrid& terrain, Terrain solid);
+
+    // Bilinear between the four nearest cell centres. Points off the grid
+    // clamp to its edge. An empty field reports everything as far away.
+    Sample          sample(sf::Vector2f p) const;
+
+    inline bool     empty() const { return _texels.empty(); }
+    inline size_t   bytes() const { return _texels.size() * sizeof(Texel); }
+
+
+    // Archive is a Snapshot to save, a Snapshot or ByteReader to load.
+    template<typename Archive>
+    inline void save(Archive& ar) const {
+        ar.write(_cellSize);
+        ar.write(_cols);
+        ar.write(_rows);
+        ar.writeArray(_texels);
+    }
+
+
+    // false if what was read doesn't add up to a field
+    template<typename Archive>
+    inline bool load(Archive& ar) {
+        ar.read(_cellSize);
+        ar.read(_cols);
+        ar.read(_rows);
+        ar.readArray(_texels);
+        if (_cols >= 0 && _rows >= 0 && _texels.size() == static_cast<size_t>(_cols) * _rows)
+            return true;
+
+        *this = DistanceField();
+        return false;
+    }
+};
+
+
+#endif //BREAKOUT_DISTANCEFIELD_H
@@ -3,25 +3,38 @@
 //
 
 #include "Entity.h"
+#include "EntityCommandBuffer.h"
 
-Entity::Entity(size_t id, const std::string& tag)
-    : _tag(tag), _id(id) {
+void Entity::destroy() {
+    if (!_active)
+        return;
 
-}
+    // inside a scheduled system: defer, the entity stays alive until the next update
+    if (auto buffer = EntityCommandBuffer::current()) {
+        buffer->destroy(getHandle());
+        return;
+    }
 
-void Entity::destroy() {
     _active = false;
+    _manager->markDead(this);
+}
+
+size_t Entity::getId() const {
+    return _index;
 }
 
-const size_t& Entity::getId() const {
-    return _id;
+EntityHandle Entity::getHandle() const {
+    return EntityHandle{ _index, _generation };
 }
 
 const std::string& Entity::getTag() const {
+    return _manager->tagName(_tag);
+}
+
+TagId Entity::getTagId() const {
     return _tag;
 }
 
 bool Entity::isActive() const {
     return _active;
 }
-
@@ -6,30 +6,33 @@
 #define BREAKOUT_ENTITY_H
 
 
-#include <tuple>
 #include <string>
+#include <utility>
 
-#include "Components.h"
-// forward declarations
-class EntityManager;
+#include "EntityManager.h"
 
-using ComponentTuple = std::tuple<CAnimation, CSprite, CHealth, CState, CTransform, CBoundingBox, CInput, CScore, CGun, CMissiles, CCollision>;
 
 class Entity {
 private:
     friend class EntityManager;
-    Entity(size_t id, const std::string& tag);      // private ctor, entities can only be created by EntityManager
+    Entity() = default;                                                 // private ctor, entities can only be created by EntityManager
 
-    const size_t            _id{ 0 };
-    const std::string       _tag{ "Default" };
-    bool                    _active{ true };
-    ComponentTuple          _components;
+    // slot fields, rewritten by EntityManager when the slot is recycled
+    uint32_t                _index{ 0 };
+    uint32_t                _generation{ 0 };
+    TagId                   _tag{ Tags::Default };
+    bool                    _active{ false };
+    uint32_t                _entitiesPos{ 0 };     // position in EntityManager's entity list
+    uint32_t                _tagPos{ 0 };          // position in its tag bucket
+    EntityManager*          _manager{ nullptr };    // components live in the manager's store
 
 public:
 
     void                    destroy();
-    const size_t&           getId() const;
+    size_t                  getId() const;
+    EntityHandle            getHandle() const;
     const std::string&      getTag() const;
+    TagId                   getTagId() const;
     bool                    isActive() const;
 
 
@@ -37,34 +40,31 @@ public:
     // Component API
     template<typename T>
     inline bool hasComponent() const {
-        return getComponent<T>().has;
+        return _manager->hasComponent<T>(_index);
     }
 
 
     template<typename T, typename... TArgs>
     inline T& addComponent(TArgs &&... mArgs) {
-        auto& component = getComponent<T>();
-        component = T(std::forward<TArgs>(mArgs)...);
-        component.has = true;
-        return component;
+        return _manager->addComponent<T>(_index, this, std::forward<TArgs>(mArgs)...);
     }
 
 
     template<typename T>
     inline bool removeComponent() {
-        return getComponent<T>().has = false;
+        return _manager->removeComponent<T>(_index);
     }
 
 
     template<typename T>
     inline T& getComponent() {
-        return std::get<T>(_components);
+        return _manager->getComponents<T>().get(_index);
     }
 
 
     template<typename T>
     inline const T& getComponent() const {
-        return std::get<T>(_components);
+        return std::as_const(*_manager).getComponents<T>().get(_index);
     }
 };
 
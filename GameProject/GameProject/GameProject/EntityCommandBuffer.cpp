@@ -0,0 +1,46 @@
+#include "EntityCommandBuffer.h"
+
+#include <tuple>
+
+
+namespace {
+    thread_local EntityCommandBuffer* tlsBuffer = nullptr;
+}
+
+
+void EntityCommandBuffer::apply(EntityManager& em) {
+    for (const auto& op : _ops)
+        op.play(*this, em, op);
+    clear();
+}
+
+
+// keeps every capacity, see the class comment
+void EntityCommandBuffer::clear() {
+    _ops.clear();
+    std::apply([](auto&... values) { (values.clear(), ...); }, _shelves);
+    _created = nullptr;
+}
+
+
+void EntityCommandBuffer::playCreate(EntityCommandBuffer& buffer, EntityManager& em, const Op& op) {
+    buffer._created = em.addEntity(static_cast<TagId>(op.value));
+    if (op.handles)
+        op.handles->push_back(buffer._created->getHandle());
+}
+
+
+void EntityCommandBuffer::playDestroy(EntityCommandBuffer&, EntityManager& em, const Op& op) {
+    if (auto e = em.get(op.target))
+        e->destroy();
+}
+
+
+EntityCommandBuffer* EntityCommandBuffer::current() {
+    return tlsBuffer;
+}
+
+
+void EntityCommandBuffer::bind(EntityCommandBuffer* buffer) {
+    tlsBuffer = buffer;
+}
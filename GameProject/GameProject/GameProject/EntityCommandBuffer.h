@@ -0,0 +1,126 @@
+#ifndef BREAKOUT_ENTITYCOMMANDBUFFER_H
+#define BREAKOUT_ENTITYCOMMANDBUFFER_H
+
+
+#include <vector>
+#include <cstdint>
+
+#include "Entity.h"
+#include "EntityManager.h"
+
+
+// Structural changes recorded by a system and played back by
+// EntityManager::update() on the main thread.
+//
+// Each buffer has exactly one writer at a time (the thread running the
+// system it belongs to), so recording takes no locks. Buffers are applied in
+// the order EntityManager created them, and each buffer in record order, so
+// the result doesn't depend on which worker ran what.
+//
+// Ops are plain records and component values wait on a vector per component
+// type; all of them keep their capacity between ticks, so once a buffer has
+// seen its busiest tick, recording doesn't allocate.
+class EntityCommandBuffer {
+private:
+    struct Op;
+    using PlayFn = void (*)(EntityCommandBuffer&, EntityManager&, const Op&);
+
+    struct Op {
+        PlayFn                      play;
+        EntityHandle                target;             // unused by create() and with()
+        uint32_t                    value{ 0 };         // index on the component's shelf, or the TagId to create
+        std::vector<EntityHandle>*  handles{ nullptr }; // create(): gets the new entity's handle
+    };
+
+    std::vector<Op>         _ops;
+    Components::Shelves     _shelves;
+    Entity*                 _created{ nullptr };    // set while applying a create() and the with()s after it
+
+    template<typename T>
+    inline std::vector<T>& shelf() {
+        return std::get<std::vector<T>>(_shelves);
+    }
+
+
+    template<typename T, typename... TArgs>
+    inline void recordAdd(PlayFn play, EntityHandle h, TArgs &&... mArgs) {
+        auto& values = shelf<T>();
+        _ops.push_back({ play, h, static_cast<uint32_t>(values.size()) });
+        values.emplace_back(std::forward<TArgs>(mArgs)...);
+    }
+
+
+    template<typename T>
+    static void playAdd(EntityCommandBuffer& buffer, EntityManager& em, const Op& op) {
+        if (auto e = em.get(op.target))
+            e->addComponent<T>(buffer.shelf<T>()[op.value]);
+    }
+
+
+    template<typename T>
+    static void playWith(EntityCommandBuffer& buffer, EntityManager&, const Op& op) {
+        if (buffer._created)
+            buffer._created->addComponent<T>(buffer.shelf<T>()[op.value]);
+    }
+
+
+    template<typename T>
+    static void playRemove(EntityCommandBuffer&, EntityManager& em, const Op& op) {
+        if (auto e = em.get(op.target))
+            e->removeComponent<T>();
+    }
+
+
+    static void playCreate(EntityCommandBuffer& buffer, EntityManager& em, const Op& op);
+    static void playDestroy(EntityCommandBuffer& buffer, EntityManager& em, const Op& op);
+
+public:
+    // Components for the new entity follow with with(); its handle is
+    // appended to *handles at playback, if given:
+    //
+    //      commands().create(Tags::Bone, &_bones)
+    //          .with<CTransform>(p)
+    //          .with<CSprite>(texture);
+    inline EntityCommandBuffer& create(TagId tag, std::vector<EntityHandle>* handles = nullptr) {
+        _ops.push_back({ &playCreate, EntityHandle{}, tag, handles });
+        return *this;
+    }
+
+
+    // component for the entity of the latest create()
+    template<typename T, typename... TArgs>
+    inline EntityCommandBuffer& with(TArgs &&... mArgs) {
+        recordAdd<T>(&playWith<T>, EntityHandle{}, std::forward<TArgs>(mArgs)...);
+        return *this;
+    }
+
+
+    inline void destroy(EntityHandle h) {
+        _ops.push_back({ &playDestroy, h });
+    }
+
+
+    template<typename T, typename... TArgs>
+    inline void addComponent(EntityHandle h, TArgs &&... mArgs) {
+        recordAdd<T>(&playAdd<T>, h, std::forward<TArgs>(mArgs)...);
+    }
+
+
+    template<typename T>
+    inline void removeComponent(EntityHandle h) {
+        _ops.push_back({ &playRemove<T>, h });
+    }
+
+
+    inline bool empty() const { return _ops.empty(); }
+    void        clear();
+
+    void        apply(EntityManager& em);
+
+    // buffer recording for the calling thread, nullptr outside scheduled systems
+    static EntityCommandBuffer*     current();
+    static void                     bind(EntityCommandBuffer* buffer);
+};
+
+
+#endif //BREAKOUT_ENTITYCOMMANDBUFFER_H
@@ -4,40 +4,116 @@
 
 #include "EntityManager.h"
 #include "Entity.h"
+#include "EntityCommandBuffer.h"
+#include "Snapshot.h"
 
-EntityManager::EntityManager() : _totalEntities(0) {}
+#include <algorithm>
 
 
-std::shared_ptr<Entity> EntityManager::addEntity(const std::string& tag) {
-    // create a new Entity object
-    auto e = std::shared_ptr<Entity>(new Entity(_totalEntities++, tag));
+namespace {
+    // the per-slot Entity fields, Entity itself also holds the manager pointer
+    struct SlotState {
+        uint32_t    generation;
+        uint32_t    entitiesPos;
+        uint32_t    tagPos;
+        TagId       tag;
+        bool        active;
+    };
+}
+
+EntityManager::EntityManager() {
+    for (auto name : Tags::names)
+        internTag(std::string(name));
+
+    // main buffer, always played back first
+    createCommandBuffer();
+}
+
+EntityManager::~EntityManager() {}
+
+
+EntityPtr EntityManager::addEntity(const std::string& tag) {
+    return addEntity(internTag(tag));
+}
+
+
+EntityPtr EntityManager::addEntity(TagId tag) {
+    // take a recycled slot, only allocate when the pool is exhausted
+    if (_freeSlots.empty())
+        growBlock();
+
+    auto e = &slot(_freeSlots.back());
+    _freeSlots.pop_back();
+    e->_tag = tag;
+    e->_active = true;
 
     // store it in entities vector
     _EntitiesToAdd.push_back(e);
-    // return shared pointer to it
     return e;
 }
 
 
 EntityVec& EntityManager::getEntities(const std::string& tag) {
-    return _entityMap[tag];
+    return getEntities(internTag(tag));
 }
 
 
-void EntityManager::update() {
-    // Remove dead entities
-    removeDeadEntities(_entities);
-    for (auto& [_, entityVec] : _entityMap)
-        removeDeadEntities(entityVec);
+EntityVec& EntityManager::getEntities(TagId tag) {
+    return _tagBuckets[tag];
+}
+
+
+TagId EntityManager::internTag(const std::string& tag) {
+    auto found = _tagIds.find(tag);
+    if (found != _tagIds.end())
+        return found->second;
+
+    auto id = static_cast<TagId>(_tagNames.size());
+    _tagIds.emplace(tag, id);
+    _tagNames.push_back(tag);
+    _tagBuckets.emplace_back();
+    return id;
+}
+
+
+const std::string& EntityManager::tagName(TagId tag) const {
+    return _tagNames[tag];
+}
+
 
+EntityPtr EntityManager::get(EntityHandle h) const {
+    if (h.index >= _blocks.size() * BlockSize)
+        return nullptr;
 
-    // add new entities
+    auto& e = slot(h.index);
+    return (e._generation == h.generation && e._active) ? &e : nullptr;
+}
+
+
+bool EntityManager::isValid(EntityHandle h) const {
+    return get(h) != nullptr;
+}
+
+
+void EntityManager::update() {
+    // play back deferred structural changes, they land in the lists below
+    for (auto& buffer : _commandBuffers)
+        buffer->apply(*this);
+
+    // add new entities, recording where they sit so removal can find them in O(1)
     for (auto e : _EntitiesToAdd)
     {
+        e->_entitiesPos = static_cast<uint32_t>(_entities.size());
         _entities.push_back(e);
-        _entityMap[e->getTag()].push_back(e);
+
+        auto& bucket = _tagBuckets[e->getTagId()];
+        e->_tagPos = static_cast<uint32_t>(bucket.size());
+        bucket.push_back(e);
     }
     _EntitiesToAdd.clear();
+
+    // Remove dead entities, including any destroyed before they were added above
+    removeDeadEntities();
 }
 
 
@@ -46,6 +122,177 @@ EntityVec& EntityManager::getEntities() {
 }
 
 
-void EntityManager::removeDeadEntities(EntityVec& v) {
-    v.erase(std::remove_if(v.begin(), v.end(), [](auto e) {return!(e->isActive()); }), v.end());
+EntityCommandBuffer& EntityManager::commands() {
+    auto bound = EntityCommandBuffer::current();
+    return bound ? *bound : *_commandBuffers.front();
+}
+
+
+EntityCommandBuffer& EntityManager::createCommandBuffer() {
+    _commandBuffers.push_back(std::make_unique<EntityCommandBuffer>());
+    return *_commandBuffers.back();
+}
+
+
+// Entity lists are written as raw pointers, blocks never move so they stay
+// valid for this manager. A snapshot is only meaningful for the manager that
+// took it.
+void EntityManager::save(Snapshot& snap) const {
+    snap.clear();
+
+    size_t slots = _blocks.size() * BlockSize;
+    snap.write(slots);
+    for (uint32_t i = 0; i < slots; ++i) {
+        auto& e = slot(i);
+        snap.write(SlotState{ e._generation, e._entitiesPos, e._tagPos, e._tag, e._active });
+    }
+
+    snap.writeArray(_freeSlots);
+    snap.writeArray(_entities);
+    snap.writeArray(_EntitiesToAdd);
+    snap.writeArray(_dead);
+
+    snap.write(_tagBuckets.size());
+    for (auto& bucket : _tagBuckets)
+        snap.writeArray(bucket);
+
+    snap.writeArray(_signatures);
+    _components.save(snap);
+}
+
+
+void EntityManager::restore(Snapshot& snap) {
+    // recorded against the world being thrown away
+    for (auto& buffer : _commandBuffers)
+        buffer->clear();
+
+    snap.rewind();
+
+    // remember every generation handed out since the snapshot before it's overwritten
+    auto total = static_cast<uint32_t>(_blocks.size() * BlockSize);
+    for (uint32_t i = 0; i < total; ++i)
+        _maxGeneration[i] = std::max(_maxGeneration[i], slot(i)._generation);
+
+    size_t slots{ 0 };
+    snap.read(slots);
+    assert(slots <= total);
+    for (uint32_t i = 0; i < slots; ++i) {
+        SlotState state;
+        snap.read(state);
+        auto& e = slot(i);
+        e._generation = state.generation;
+        e._entitiesPos = state.entitiesPos;
+        e._tagPos = state.tagPos;
+        e._tag = state.tag;
+        e._active = state.active;
+    }
+
+    snap.readArray(_freeSlots);
+    snap.readArray(_entities);
+    snap.readArray(_EntitiesToAdd);
+    snap.readArray(_dead);
+
+    // tags interned since the snapshot keep their id, their bucket is just empty
+    size_t tags{ 0 };
+    snap.read(tags);
+    assert(tags <= _tagBuckets.size());
+    for (size_t t = 0; t < _tagBuckets.size(); ++t) {
+        if (t < tags)
+            snap.readArray(_tagBuckets[t]);
+        else
+            _tagBuckets[t].clear();
+    }
+
+    snap.readArray(_signatures);
+    _components.load(snap);
+
+    // Blocks grown after the snapshot stay allocated. Their slots go in front
+    // of the free list so the slots handed out next are the ones the snapshot
+    // would have handed out.
+    auto extra = total - static_cast<uint32_t>(slots);
+    _signatures.resize(total, 0);
+    _freeSlots.insert(_freeSlots.begin(), extra, 0);
+    for (uint32_t k = 0; k < extra; ++k) {
+        _freeSlots[k] = total - 1 - k;
+        slot(total - 1 - k)._active = false;
+    }
+
+    // A free slot may have been handed out since the snapshot, so it starts
+    // past anything it has had. Slots live in the snapshot keep the snapshot's
+    // generation for its handles and move past the rest when they next die.
+    for (auto i : _freeSlots) {
+        auto& e = slot(i);
+        e._generation = std::max(e._generation, _maxGeneration[i]) + 1;
+        _maxGeneration[i] = e._generation;
+    }
+}
+
+
+void EntityManager::markDead(EntityPtr e) {
+    _dead.push_back(e);
+}
+
+
+// Cost is proportional to the number of entities destroyed since the last
+// update, untouched tag buckets are never visited.
+void EntityManager::removeDeadEntities() {
+    for (auto e : _dead) {
+        unlink(_entities, &Entity::_entitiesPos, e);
+        unlink(_tagBuckets[e->getTagId()], &Entity::_tagPos, e);
+
+        _components.removeAll(e->getId(), _signatures[e->getId()]);
+        _signatures[e->getId()] = 0;
+
+        // bump the generation so every outstanding handle to it goes stale,
+        // past any it had before a restore() took it back
+        e->_generation = std::max(e->_generation, _maxGeneration[e->_index]) + 1;
+        _maxGeneration[e->_index] = e->_generation;
+        _freeSlots.push_back(e->_index);
+    }
+    _dead.clear();
+}
+
+
+// swap-and-pop e out of v, fixing the back-index (pos) of whichever entity got moved
+void EntityManager::unlink(EntityVec& v, uint32_t Entity::* pos, EntityPtr e) {
+    auto moved = v.back();
+    v[e->*pos] = moved;
+    moved->*pos = e->*pos;
+    v.pop_back();
+}
+
+
+Entity& EntityManager::slot(uint32_t index) const {
+    return _blocks[index / BlockSize][index % BlockSize];
+}
+
+
+// allocate one more block of entities and put all of it on the free list
+void EntityManager::growBlock() {
+    auto first = static_cast<uint32_t>(_blocks.size() * BlockSize);
+    _blocks.push_back(std::unique_ptr<Entity[]>(new Entity[BlockSize]));
+    _signatures.resize(_blocks.size() * BlockSize, 0);
+    _maxGeneration.resize(_blocks.size() * BlockSize, 0);
+
+    // pushed in reverse so the lowest index is handed out first
+    _freeSlots.reserve(_freeSlots.size() + BlockSize);
+    for (uint32_t i = BlockSize; i-- > 0; ) {
+        auto& e = slot(first + i);
+        e._index = first + i;
+        e._manager = this;
+        _freeSlots.push_back(first + i);
+    }
+
+    // dead entities are moved into the free list during update, keep room for all of them
+    _entities.reserve(_blocks.size() * BlockSize);
+}
+
+
+void EntityManager::reserveSlots(TagId tag, size_t n) {
+    while (_freeSlots.size() < n)
+        growBlock();
+
+    _EntitiesToAdd.reserve(_EntitiesToAdd.size() + n);
+    _dead.reserve(_dead.size() + n);
+    _tagBuckets[tag].reserve(_tagBuckets[tag].size() + n);
 }
@@ -6,39 +6,157 @@
 #define BREAKOUT_ENTITYMANAGER_H
 
 
-#include <map>
 #include <vector>
+#include <deque>
 #include <string>
 #include <memory>
+#include <cstdint>
+#include <unordered_map>
+
+#include "ComponentStore.h"
+#include "Tags.h"
 
 //forward declare
 class Entity;
+class EntityCommandBuffer;
+class Snapshot;
+
+
+// Weak reference to an entity: slot index + generation of that slot.
+// A handle goes stale as soon as its entity is destroyed, and stays stale
+// after the slot is recycled because the generation no longer matches.
+struct EntityHandle {
+    static constexpr uint32_t invalidIndex = UINT32_MAX;
+
+    uint32_t    index{ invalidIndex };
+    uint32_t    generation{ 0 };
+
+    bool operator==(const EntityHandle&) const = default;
+};
 
-using sPtrEntt = std::shared_ptr<Entity>;
-using EntityVec = std::vector<std::shared_ptr<Entity>>;
-using EntityMap = std::map <std::string, EntityVec>;
+
+using EntityPtr = Entity*;                  // non-owning, storage belongs to EntityManager
+using EntityVec = std::vector<EntityPtr>;
 
 
 class EntityManager
 {
 private:
+    // Entities live in fixed-size blocks that are never freed or moved, so an
+    // EntityPtr stays valid for the manager's lifetime and a dead entity's slot
+    // (and the component capacity behind it) is simply handed out again.
+    static constexpr uint32_t               BlockSize = 256;
+
+    std::vector<std::unique_ptr<Entity[]>>  _blocks;        // owns every Entity, slot i is _blocks[i / BlockSize][i % BlockSize]
+    std::vector<uint32_t>                   _freeSlots;     // unused slots, popped from the back
+    std::vector<uint32_t>                   _maxGeneration; // per slot, highest generation it has had, survives restore()
+
     EntityVec	    _entities;
-    EntityMap	    _entityMap;
-    size_t		    _totalEntities{ 0 };
     EntityVec	    _EntitiesToAdd;
+    EntityVec	    _dead;          // destroyed since the last update, filled by Entity::destroy()
+
+    // deferred structural changes, applied in this order at the start of update()
+    std::vector<std::unique_ptr<EntityCommandBuffer>>   _commandBuffers;
+    Components      _components;
+    std::vector<Signature>  _signatures;    // component mask per slot
 
-    void		    removeDeadEntities(EntityVec& v);
+    // tags are interned once, after that every lookup is an index into _tagBuckets
+    std::unordered_map<std::string, TagId>  _tagIds;
+    std::deque<std::string>                 _tagNames;      // deque so getTag() references stay valid
+    std::vector<EntityVec>                  _tagBuckets;    // entities per TagId
+
+    friend class Entity;
+    void		    markDead(EntityPtr e);
+    void		    removeDeadEntities();
+    void		    unlink(EntityVec& v, uint32_t Entity::* pos, EntityPtr e);
+    void		    growBlock();
+    void		    reserveSlots(TagId tag, size_t n);
+    Entity&		    slot(uint32_t index) const;
 
 public:
     EntityManager();
+    ~EntityManager();
 
-    std::shared_ptr<Entity>         addEntity(const std::string& tag);
+    EntityPtr                       addEntity(TagId tag);
+    EntityPtr                       addEntity(const std::string& tag);
     EntityVec&                      getEntities();
+    EntityVec&                      getEntities(TagId tag);
     EntityVec&                      getEntities(const std::string& tag);
 
+    TagId                           internTag(const std::string& tag);
+    const std::string&              tagName(TagId tag) const;
+
+    // O(1), nullptr if the handle is stale or the entity has been destroyed
+    EntityPtr                       get(EntityHandle h) const;
+    bool                            isValid(EntityHandle h) const;
+
     void                            update();
+
+    // The buffer for the calling thread: the running system's own buffer inside
+    // a scheduled system, otherwise the main buffer. Use it for create/destroy/
+    // add/remove from code that may run on a worker thread.
+    EntityCommandBuffer&            commands();
+    EntityCommandBuffer&            createCommandBuffer();
+
+    // Copy the whole world (slots, lists, tags, components) into snap / back
+    // out of it. Take snapshots between ticks: commands still pending in the
+    // buffers are not captured, and restore() drops them. Handles and
+    // EntityPtrs from the snapshot are valid again after restore(); handles
+    // taken after it are stale for good, the slots they point at never hand
+    // out their generation again.
+    void                            save(Snapshot& snap) const;
+    void                            restore(Snapshot& snap);
+
+
+    // pre-warm the pool so n entities of this tag, each owning Ts..., can be
+    // spawned without touching the allocator
+    template<typename... Ts>
+    inline void reserve(TagId tag, size_t n) {
+        reserveSlots(tag, n);
+        (getComponents<Ts>().reserve(n, _blocks.size() * BlockSize), ...);
+    }
+
+
+    // packed per-type component arrays, iterate these instead of getEntities()
+    // when a system only cares about entities that own a given component
+    template<typename T>
+    inline SparseSet<T>& getComponents() {
+        return _components.getSet<T>();
+    }
+
+
+    // entities owning every one of Ts..., see View
+    template<typename... Ts>
+    inline View<Ts...> view() {
+        return View<Ts...>(_signatures, getComponents<Ts>()...);
+    }
+
+
+    template<typename T>
+    inline bool hasComponent(size_t id) const {
+        return (_signatures[id] & Components::maskOf<T>()) != 0;
+    }
+
+
+    template<typename T, typename... TArgs>
+    inline T& addComponent(size_t id, EntityPtr owner, TArgs &&... mArgs) {
+        _signatures[id] |= Components::maskOf<T>();
+        return getComponents<T>().emplace(id, owner, std::forward<TArgs>(mArgs)...);
+    }
+
+
+    template<typename T>
+    inline bool removeComponent(size_t id) {
+        _signatures[id] &= ~Components::maskOf<T>();
+        return getComponents<T>().remove(id);
+    }
+
+
+    template<typename T>
+    inline const SparseSet<T>& getComponents() const {
+        return _components.getSet<T>();
+    }
 };
 
 
 #endif //BREAKOUT_ENTITYMANAGER_H
-
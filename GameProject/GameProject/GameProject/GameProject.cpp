@@ -6,9 +6,13 @@
 #include "Assets.h"
 #include "SoundPlayer.h"
 #include "GameEngine.h"
+#include "EntityCommandBuffer.h"
+#include "Snapshot.h"
 
 #include <random>
+#include <algorithm>
 #include <fstream>
+#include <filesystem>
 #include <iostream>
 #include <iomanip>
 
@@ -47,82 +51,39 @@ void initSnowflakes(int count) {
 	}
 }
 
-std::vector<BlockingSquare> obstacles;
+// Straight from the level's terrain image on disk; on a cache hit it is
+// never decoded. Levels without a Terrain line, or whose image won't load,
+// fall back to reading back their background texture.
 void GameProject::generateBlockingSquares()
 {
-	if (_backgroundImage.getSize().x == 0 || _backgroundImage.getSize().y == 0)
-		return;
-
 	std::cout << "Generating Blocking Squares...\n";
+	sf::Clock clock;
+	const auto& terrainPath = _levelData.terrainPath;
+	const auto& bkgName = _levelData.bkgName;
+	auto load = LevelGeometry::Load::Failed;
+	if (!terrainPath.empty()) {
+		auto cacheName = std::filesystem::path(terrainPath).stem().string();
+		load = _level.loadOrBuild(terrainPath, _levelData.colours, "../cache/" + cacheName + ".geometry");
+		if (load == LevelGeometry::Load::Failed)
+			std::cerr << "Terrain " << terrainPath << " failed to load, reading back " << bkgName << "\n";
+	}
+	if (load == LevelGeometry::Load::Failed && !bkgName.empty()) {
+		auto background = Assets::getInstance().getTexture(bkgName).copyToImage();
+		load = _level.loadOrBuild(background, _levelData.colours, "../cache/" + bkgName + ".geometry");
+	}
+	if (load == LevelGeometry::Load::Failed)
+		return;
 
-	obstacles.clear();
-	unsigned int width = _backgroundImage.getSize().x;
-	unsigned int height = _backgroundImage.getSize().y;
-
-
-	const int STEP_SIZE = 40;
-	const int BLOCK_SIZE = 40; // Original block size
-	const int COLLISION_SIZE = 16; // Smaller collision size
-	const int BOUNDARY_OFFSET = 100; // Increased from 50 to 120 - allows more space between track and obstacles
-	const int GRASS_MARGIN = 120; // How much grass area to leave accessible
-
-
-	std::set<std::pair<int, int>> blockPositions;
-
-
-	for (unsigned int y = 0; y < height; y += STEP_SIZE)
-	{
-		for (unsigned int x = 0; x < width; x += STEP_SIZE)
-		{
-			// Check if current pixel is track
-			sf::Color pixelColor = _backgroundImage.getPixel(x, y);
-			if (pixelColor.r == 66 && pixelColor.g == 80 && pixelColor.b == 86)
-			{
-				// Scan around the track pixel for grass, but farther away from the track edge
-				for (int dy = -BOUNDARY_OFFSET; dy <= BOUNDARY_OFFSET; dy += BLOCK_SIZE)
-				{
-					for (int dx = -BOUNDARY_OFFSET; dx <= BOUNDARY_OFFSET; dx += BLOCK_SIZE)
-					{
-						int newX = x + dx;
-						int newY = y + dy;
-
-						// Boundary check
-						if (newX >= 0 && newX < width && newY >= 0 && newY < height)
-						{
-							sf::Color grassColor = _backgroundImage.getPixel(newX, newY);
-
-							// Check for grass color
-							if (grassColor.r >= 15 && grassColor.r <= 30 &&
-								grassColor.g >= 210 && grassColor.g <= 230 &&
-								grassColor.b >= 20 && grassColor.b <= 35)
-							{
-								// Only place blocking squares beyond the GRASS_MARGIN distance
-								float distanceToTrack = std::sqrt(dx * dx + dy * dy);
-								if (distanceToTrack > GRASS_MARGIN)
-								{
-									// Use a set to prevent duplicate blocking squares
-									blockPositions.insert({ newX, newY });
-								}
-							}
-						}
-					}
-				}
-			}
-		}
-	}
-
-	// Convert unique block positions to obstacles with smaller collision boxes
-	for (const auto& pos : blockPositions)
-	{
-		// Center the smaller collision box within the visual block
-		int collisionX = pos.first + (BLOCK_SIZE - COLLISION_SIZE) / 2;
-		int collisionY = pos.second + (BLOCK_SIZE - COLLISION_SIZE) / 2;
-
-		obstacles.push_back({ collisionX, collisionY, COLLISION_SIZE, COLLISION_SIZE });
-	}
+	std::cout << (load == LevelGeometry::Load::Cached ? "Loaded from cache in " : "Built and cached in ")
+		<< clock.getElapsedTime().asMilliseconds() << " ms" << std::endl;
 
-	std::cout << "Track Pixels Found: " << blockPositions.size() << std::endl;
-	std::cout << "Blocking Squares Generated: " << obstacles.size() << std::endl;
+	std::cout << "Track Pixels Found: " << _level.blockCount << std::endl;
+	std::cout << "Blocking Squares Generated: " << _level.obstacles.size()
+		<< " (merged from " << _level.blockCount << ")" << std::endl;
+	std::cout << "Terrain grid: " << _level.terrain.size().x << "x" << _level.terrain.size().y
+		<< " cells, " << _level.terrain.bytes() << " bytes" << std::endl;
+	std::cout << "Wall distance field: " << _level.wallField.bytes() << " bytes" << std::endl;
+	std::cout << "Spawn cells: " << _level.spawns.size() << std::endl;
 }
 
 
@@ -146,6 +107,7 @@ void renderSnowflakes(sf::RenderWindow& window) {
 GameProject::GameProject(GameEngine* gameEngine, const std::string& levelPath)
 	: Scene(gameEngine)
 	, _worldView(gameEngine->window().getDefaultView()),
+	_scheduler(_entityManager),
 	_levelPath(levelPath)
 
 {
@@ -153,10 +115,14 @@ GameProject::GameProject(GameEngine* gameEngine, const std::string& levelPath)
 
 	spawnPlayerForLevel();
 
+	// link the player and background, then keep the world as it is before the first tick
+	_entityManager.update();
+	_raceStart.reserve(64 * 1024);
+	saveSnapshot(_raceStart);
 
-	if (levelPath.find("../level3.txt") != std::string::npos) {
+	if (_levelData.snowflakes > 0) {
 		_enableSnow = true;
-		initSnowflakes(100);
+		initSnowflakes(static_cast<int>(_levelData.snowflakes));
 	}
 
 	/*_finishLine = sf::FloatRect(100.f, 50.f, 200.f, 20.f);
@@ -167,50 +133,84 @@ GameProject::GameProject(GameEngine* gameEngine, const std::string& levelPath)
 
 
 
-void GameProject::setupCheckpoints(const std::string& levelPath)
+void GameProject::setupCheckpoints()
 {
 	_checkpoints.clear();
 	_currentCheckpoint = 0;
 	_allCheckpointsReached = false;
 
-	// More precise checkpoint placements based on track layout
-	// Let's make them more visible for debugging
-	_checkpoints = {
-		{ sf::FloatRect(310.f, 100.f, 100.f, 100.f) },
-		{ sf::FloatRect(1510.f, 200.f, 100.f, 100.f) },
-		{ sf::FloatRect(1370.f, 720.f, 100.f, 100.f) },
-		{ sf::FloatRect(290.f, 940.f, 100.f, 100.f) },
-		{ sf::FloatRect(1069.f, 650.f, 100.f, 100.f) }
+	for (const auto& checkpoint : _levelData.checkpoints)
+		_checkpoints.push_back({ checkpoint.area, false, checkpoint.bonus });
 
+	_finishLine = _levelData.finishLine;
 
-	};
+	std::cout << "Checkpoints and finish line set up. Total checkpoints: " << _checkpoints.size() << std::endl;
+}
 
-	// Make finish line more visible
-	_finishLine = sf::FloatRect(610.f, 400.f, 75.f, 100.f);
 
-	// For debugging, make checkpoints more visible
-	for (auto& checkpoint : _checkpoints) {
-		checkpoint.area.width = 50.f;  // Make larger for debugging
-		checkpoint.area.height = 200.f;
-	}
 
-	std::cout << "Checkpoints and finish line set up. Total checkpoints: " << _checkpoints.size() << std::endl;
+// Race state that lives on the scene rather than in components. Written after
+// the EntityManager's own data, so restore must read it back in this order.
+void GameProject::saveSnapshot(Snapshot& snap) const
+{
+	_entityManager.save(snap);
+
+	snap.write(rng);
+	snap.write(_player);
+	snap.write(_isPaused);
+	snap.writeArray(_checkpoints);
+	snap.write(_currentCheckpoint);
+	snap.write(_allCheckpointsReached);
+	snap.write(_lapCount);
+	snap.write(_lastLapTime);
+	snap.write(m_countdownTime);
+	snap.write(m_raceTime);
+	snap.write(m_timerActive);
+	snap.write(m_raceStarted);
+	snap.write(_barkCounter);
+	snap.writeArray(_barrels);
+	snap.write(_barrelsSpawned);
+	snap.writeArray(_bones);
+	snap.write(_bonesSpawned);
+	snap.write(_playerSpeedBoost);
+	snap.write(_speedBoostTimer);
+	snap.write(_showTimeBonus);
+	snap.write(_timeBonusDisplayTime);
+	snap.write(_lastTimeBonus);
 }
 
 
-
-void GameProject::resetLapProgress()
+void GameProject::restoreSnapshot(Snapshot& snap)
 {
-	for (auto& checkpoint : _checkpoints) {
-		checkpoint.reached = false;
-	}
-	_currentCheckpoint = 0;
-	_allCheckpointsReached = false;
-	m_raceStarted = false;
-	m_countdownTime = 3.0f; // 3-second countdown
-	m_timerActive = false;
-	m_raceTime = 10.0f; // Reset race time
-	_lapCount = 0;
+	_entityManager.restore(snap);
+
+	snap.read(rng);
+	snap.read(_player);
+	snap.read(_isPaused);
+	snap.readArray(_checkpoints);
+	snap.read(_currentCheckpoint);
+	snap.read(_allCheckpointsReached);
+	snap.read(_lapCount);
+	snap.read(_lastLapTime);
+	snap.read(m_countdownTime);
+	snap.read(m_raceTime);
+	snap.read(m_timerActive);
+	snap.read(m_raceStarted);
+	snap.read(_barkCounter);
+	snap.readArray(_barrels);
+	snap.read(_barrelsSpawned);
+	snap.readArray(_bones);
+	snap.read(_bonesSpawned);
+	snap.read(_playerSpeedBoost);
+	snap.read(_speedBoostTimer);
+	snap.read(_showTimeBonus);
+	snap.read(_timeBonusDisplayTime);
+	snap.read(_lastTimeBonus);
+
+	// proxies and scratch still point at the world that was just replaced
+	_broadphase.clear();
+	_bodies.clear();
+	_sweepHits.clear();
 }
 
 
@@ -258,42 +258,11 @@ void GameProject::checkLapProgress()
 			std::cout << "Checkpoint " << _currentCheckpoint + 1 << " reached!" << std::endl;
 			_checkpoints[_currentCheckpoint].reached = true;
 
-			// Add time based on which checkpoint was reached
-			if (_currentCheckpoint == 0) { // First checkpoint
-				m_raceTime += 10.0f; // Add 10 seconds
-				_lastTimeBonus = 10.0f;
-
-				// Show time bonus notification
-				_showTimeBonus = true;
-				_timeBonusDisplayTime = 2.0f; // Show for 2 seconds
-			}
-			else if (_currentCheckpoint == 1) { // Second checkpoint
-				m_raceTime += 15.0f; // Add 15 seconds
-				_lastTimeBonus = 15.0f;
-
-				// Show time bonus notification
-				_showTimeBonus = true;
-				_timeBonusDisplayTime = 2.0f; // Show for 2 seconds
-			}
-			else if (_currentCheckpoint == 2) { // Second checkpoint
-				m_raceTime += 20.0f; // Add 15 seconds
-				_lastTimeBonus = 20.0f;
-
-				// Show time bonus notification
-				_showTimeBonus = true;
-				_timeBonusDisplayTime = 2.0f; // Show for 2 seconds
-			}
-			else if (_currentCheckpoint == 3) { // Second checkpoint
-				m_raceTime += 15.0f; // Add 15 seconds
-				_lastTimeBonus = 15.0f;
-
-				// Show time bonus notification
-				_showTimeBonus = true;
-				_timeBonusDisplayTime = 2.0f; // Show for 2 seconds
-			}
-			else if (_currentCheckpoint == 4) { // Second checkpoint
-				m_raceTime += 15.0f; // Add 15 seconds
-				_lastTimeBonus = 15.0f;
+			// Add the checkpoint's time bonus from the level file
+			float bonus = _checkpoints[_currentCheckpoint].bonus;
+			if (bonus > 0.f) {
+				m_raceTime += bonus;
+				_lastTimeBonus = bonus;
 
 				// Show time bonus notification
 				_showTimeBonus = true;
@@ -357,41 +326,6 @@ void GameProject::checkLapProgress()
 
 }
 
-void GameProject::resetRaceState()
-{
-	// Clear all barrels and bones
-	for (auto& barrel : _barrels) {
-		if (barrel->isActive()) barrel->destroy();
-	}
-	for (auto& bone : _bones) {
-		if (bone->isActive()) bone->destroy();
-	}
-	_barrels.clear();
-	_bones.clear();
-	_barrelsSpawned = false;
-	_bonesSpawned = false;
-
-	// Reset bark count
-	_barkCounter = 2;
-
-	// Reset timer
-	m_raceTime = 20.0f;
-	m_timerActive = false;
-
-	// Reset speed boost
-	_playerSpeedBoost = false;
-	_speedBoostTimer = 0.0f;
-
-	// Clear any remaining effects
-	if (_player && _player->hasComponent<CSprite>()) {
-		auto& playerSprite = _player->getComponent<CSprite>();
-		auto& sr = Assets::getInstance().getSpriteRec("PugLeft");
-		playerSprite.sprite.setTexture(Assets::getInstance().getTexture(sr.texName));
-		playerSprite.sprite.setTextureRect(sr.texRect);
-	}
-}
-
-
 // Add these declarations to your GameProject.h file in the private section:
 /*
 private:
@@ -408,11 +342,7 @@ private:
 
 void GameProject::sAnimation(sf::Time dt)
 {
-
-	for (auto e : _entityManager.getEntities()) {
-		if (!e->hasComponent<CAnimation>()) continue;
-
-		auto& anim = e->getComponent<CAnimation>();
+	for (auto [e, anim, spriteComp] : _entityManager.view<CAnimation, CSprite>()) {
 		anim.countDown -= dt;
 
 		std::cout << "Countdown: " << anim.countDown.asSeconds() << " seconds\n";
@@ -434,8 +364,7 @@ void GameProject::sAnimation(sf::Time dt)
 				}
 			}
 
-			auto& sprite = e->getComponent<CSprite>().sprite;
-			sprite.setTextureRect(sf::IntRect(
+			spriteComp.sprite.setTextureRect(sf::IntRect(
 				anim.currentFrame * anim.frameSize.x, 0,
 				anim.frameSize.x, anim.frameSize.y
 			));
@@ -454,16 +383,66 @@ void GameProject::sMovement(sf::Time dt)
 {
 	playerMovement();
 
-	// move all objects
-	for (auto& e : _entityManager.getEntities()) {
-		if (e->hasComponent<CTransform>()) {
-			auto& tfm = e->getComponent<CTransform>();
-			tfm.pos += tfm.vel * dt.asSeconds();
-			tfm.angle += tfm.angVel * dt.asSeconds();
+	// move everything that moves itself, remembering where it started for the swept pass
+	for (auto [e, tfm] : _entityManager.view<CTransform>().without<CRigidBody>()) {
+		tfm.prevPos = tfm.pos;
+		tfm.pos += tfm.vel * dt.asSeconds();
+	}
+
+	integrateBodies(dt);
+
+	for (auto [e, spin, tfm] : _entityManager.view<CSpin, CTransform>())
+		tfm.angle += spin.angVel * dt.asSeconds();
+}
+
+// Rigid bodies that are awake: damp, move, and put to sleep once they have
+// been nearly still for a while. Sleeping bodies have no CAwake and are never
+// visited here; pushBody wakes them when something runs into them.
+void GameProject::integrateBodies(sf::Time dt)
+{
+	constexpr float sleepSpeed = 4.f;	// px/s, slower than this counts as still
+	constexpr float sleepDelay = 0.5f;	// seconds of being still before sleeping
+
+	float t = dt.asSeconds();
+	for (auto [e, awake, body, tfm] : _entityManager.view<CAwake, CRigidBody, CTransform>()) {
+		tfm.prevPos = tfm.pos;
+		tfm.vel *= std::max(0.f, 1.f - body.damping * t);
+		tfm.pos += tfm.vel * t;
+
+		body.restTime = (length(tfm.vel) < sleepSpeed) ? body.restTime + t : 0.f;
+		if (body.restTime > sleepDelay) {
+			tfm.vel = sf::Vector2f(0.f, 0.f);
+			_entityManager.commands().removeComponent<CAwake>(e->getHandle());
 		}
 	}
 }
 
+
+// Something without a rigid body (the player, or a wall) moving at pusherVel
+// runs into body; normal points from the body towards it. The pusher counts
+// as infinitely heavy, so the body takes the whole impulse.
+void GameProject::pushBody(EntityPtr body, const sf::Vector2f& normal, const sf::Vector2f& pusherVel)
+{
+	auto& rb = body->getComponent<CRigidBody>();
+	auto& tfm = body->getComponent<CTransform>();
+
+	sf::Vector2f rel = pusherVel - tfm.vel;
+	float closing = -(rel.x * normal.x + rel.y * normal.y);
+	if (closing <= 0.f || rb.invMass == 0.f) return;
+
+	tfm.vel -= normal * ((1.f + rb.restitution) * closing);
+	wakeBody(body);
+}
+
+
+void GameProject::wakeBody(EntityPtr body)
+{
+	body->getComponent<CRigidBody>().restTime = 0.f;
+	if (!body->hasComponent<CAwake>())
+		_entityManager.commands().addComponent<CAwake>(body->getHandle());
+}
+
+
 void GameProject::sCollisions()
 {
 	if (!_player) return;
@@ -471,33 +450,49 @@ void GameProject::sCollisions()
 	auto& playerTransform = _player->getComponent<CTransform>();
 	auto& playerBox = _player->getComponent<CBoundingBox>();
 
-	// Define player bounding rectangle
-	sf::FloatRect playerRect(playerTransform.pos.x - playerBox.halfSize.x,
-		playerTransform.pos.y - playerBox.halfSize.y,
-		playerBox.size.x, playerBox.size.y);
-
-	// Check collision with barrels
-	for (auto& barrel : _entityManager.getEntities("Barrel"))
+	// Gather every other body that blocks the player (the barrels)
+	_bodyBoxes.clear();
+	_bodies.clear();
+	for (auto [e, box, tfm] : _entityManager.view<CBoundingBox, CTransform>())
 	{
-		auto& barrelTransform = barrel->getComponent<CTransform>();
-		auto& barrelBox = barrel->getComponent<CBoundingBox>();
+		if (e == _player || !_collisions.blocks(playerBox.layer, box.layer)) continue;
+		_bodyBoxes.push(tfm.pos, box.halfSize);
+		_bodies.push_back(e);
+	}
 
-		sf::FloatRect barrelRect(barrelTransform.pos.x - barrelBox.halfSize.x,
-			barrelTransform.pos.y - barrelBox.halfSize.y,
-			barrelBox.size.x, barrelBox.size.y);
+	sweepPlayer(playerTransform, playerBox);
 
-		if (playerRect.intersects(barrelRect))
+	// test the player against all of the bodies in one batch
+
+	if (Physics::overlapBatch(playerTransform.pos, playerBox.halfSize, _bodyBoxes, _bodyOverlaps) > 0)
+	{
+		for (size_t i = 0; i < _bodies.size(); ++i)
 		{
+			if (!_bodyOverlaps.hit(i)) continue;
+
+			// pushable: the body gives way along the shallower axis and gets shoved
+			if (_bodies[i]->hasComponent<CRigidBody>() && _bodies[i]->getComponent<CRigidBody>().invMass > 0.f)
+			{
+				auto& bodyTransform = _bodies[i]->getComponent<CTransform>();
+				sf::Vector2f normal = (_bodyOverlaps.x[i] < _bodyOverlaps.y[i])
+					? sf::Vector2f(playerTransform.pos.x < bodyTransform.pos.x ? -1.f : 1.f, 0.f)
+					: sf::Vector2f(0.f, playerTransform.pos.y < bodyTransform.pos.y ? -1.f : 1.f);
+				bodyTransform.pos -= normal * std::min(_bodyOverlaps.x[i], _bodyOverlaps.y[i]);
+				pushBody(_bodies[i], normal, playerTransform.vel);
+				continue;
+			}
+
 			// Determine pushback direction
+			sf::Vector2f barrelPos(_bodyBoxes.cx[i], _bodyBoxes.cy[i]);
 			sf::Vector2f pushback(0.f, 0.f);
-			if (playerTransform.pos.x < barrelTransform.pos.x)
+			if (playerTransform.pos.x < barrelPos.x)
 				pushback.x = -1;
-			else if (playerTransform.pos.x > barrelTransform.pos.x)
+			else if (playerTransform.pos.x > barrelPos.x)
 				pushback.x = 1;
 
-			if (playerTransform.pos.y < barrelTransform.pos.y)
+			if (playerTransform.pos.y < barrelPos.y)
 				pushback.y = -1;
-			else if (playerTransform.pos.y > barrelTransform.pos.y)
+			else if (playerTransform.pos.y > barrelPos.y)
 				pushback.y = 1;
 
 			// Move the player back
@@ -505,54 +500,106 @@ void GameProject::sCollisions()
 		}
 	}
 
-	// Check collision with blocking squares
-	for (const auto& obstacle : obstacles)
+	// Body vs body. The player has its own swept and batched passes above, the
+	// broadphase pairs cover everything else: separate each overlapping solid
+	// pair along its shallower axis in proportion to their inverse masses, then
+	// exchange an impulse if they are closing. Pickups and triggers are
+	// handled by whoever consumes their pairs (sBonePickup).
+	_broadphase.update(_entityManager, _collisions);
+	for (auto [a, b] : _broadphase.pairs())
 	{
-		sf::FloatRect obstacleRect(obstacle.x, obstacle.y, obstacle.width, obstacle.height);
+		if (a == _player || b == _player) continue;
+		if (!_collisions.blocks(a->getComponent<CBoundingBox>().layer, b->getComponent<CBoundingBox>().layer)) continue;
 
-		if (playerRect.intersects(obstacleRect))
-		{
-			// Store previous position to reset after collision
-			sf::Vector2f previousPos = playerTransform.pos;
+		if (!Physics::resolveContact(a, b)) continue;
 
-			// Determine collision side and pushback direction
-			sf::Vector2f pushback(0.f, 0.f);
+		if (a->hasComponent<CRigidBody>()) wakeBody(a);
+		if (b->hasComponent<CRigidBody>()) wakeBody(b);
+	}
+
+	// moving bodies bounce off the walls
+	for (auto [e, awake, body, tfm, box] : _entityManager.view<CAwake, CRigidBody, CTransform, CBoundingBox>())
+	{
+		if (!_collisions.blocks(box.layer, CollisionLayer::Wall)) continue;
 
+		float radius = std::min(box.halfSize.x, box.halfSize.y);
+		auto wall = _level.wallField.sample(tfm.pos);
+		if (wall.distance >= radius) continue;
 
-			float overlapX = std::min(playerRect.left + playerRect.width, obstacleRect.left + obstacleRect.width) -
-				std::max(playerRect.left, obstacleRect.left);
-			float overlapY = std::min(playerRect.top + playerRect.height, obstacleRect.top + obstacleRect.height) -
-				std::max(playerRect.top, obstacleRect.top);
+		tfm.pos += wall.normal * (radius - wall.distance);
+		float into = tfm.vel.x * wall.normal.x + tfm.vel.y * wall.normal.y;
+		if (into < 0.f)
+			tfm.vel -= wall.normal * ((1.f + body.restitution) * into);
+	}
 
-			// Push back in the direction of least resistance
-			if (overlapX < overlapY) {
+	// Keep the player's collision circle outside the walls: one field sample
+	// gives how deep it is and which way is out, and pushing out along the
+	// normal lets it slide along the wall instead of stopping dead.
+	if (!_collisions.blocks(playerBox.layer, CollisionLayer::Wall)) return;
 
-				if (playerTransform.pos.x < obstacle.x + obstacle.width / 2)
-					pushback.x = -overlapX;
-				else
-					pushback.x = overlapX;
-			}
-			else {
+	float radius = std::min(playerBox.halfSize.x, playerBox.halfSize.y);
+	auto wall = _level.wallField.sample(playerTransform.pos);
+	if (wall.distance < radius)
+		playerTransform.pos += wall.normal * (radius - wall.distance);
+}
 
-				if (playerTransform.pos.y < obstacle.y + obstacle.height / 2)
-					pushback.y = -overlapY;
-				else
-					pushback.y = overlapY;
-			}
 
-			// Apply pushback
-			playerTransform.pos += pushback;
+// Continuous collision for the player's move this tick (prevPos -> pos), so a
+// fast pug stops at the first obstacle or barrel in its way instead of
+// tunnelling through it. On contact the rest of the move slides along the
+// face that was hit; two slides cover running into a corner.
+void GameProject::sweepPlayer(CTransform& tfm, const CBoundingBox& box)
+{
+	constexpr float skin = 0.01f;		// stop this far short of the face so the next tick starts outside
+
+	sf::Vector2f from = tfm.prevPos;
+	sf::Vector2f delta = tfm.pos - tfm.prevPos;
 
+	for (int pass = 0; pass < 3 && (delta.x != 0.f || delta.y != 0.f); ++pass)
+	{
+		// candidates: obstacles near the swept box, plus every body
+		sf::Vector2f lo(std::min(from.x, from.x + delta.x) - box.halfSize.x, std::min(from.y, from.y + delta.y) - box.halfSize.y);
+		sf::Vector2f hi(std::max(from.x, from.x + delta.x) + box.halfSize.x, std::max(from.y, from.y + delta.y) + box.halfSize.y);
+
+		_sweepHits.clear();
+		if (_collisions.blocks(box.layer, CollisionLayer::Wall))
+			_level.obstacleGrid.query(sf::FloatRect(lo, hi - lo), _sweepHits);
+
+		_sweepBoxes.clear();
+		for (auto i : _sweepHits) {
+			const auto& r = _level.obstacleGrid.box(i);
+			_sweepBoxes.push(sf::Vector2f(r.left + r.width / 2.f, r.top + r.height / 2.f), sf::Vector2f(r.width / 2.f, r.height / 2.f));
+		}
+		for (size_t i = 0; i < _bodyBoxes.size(); ++i)
+			_sweepBoxes.push(sf::Vector2f(_bodyBoxes.cx[i], _bodyBoxes.cy[i]), sf::Vector2f(_bodyBoxes.hx[i], _bodyBoxes.hy[i]));
 
-			sf::FloatRect newPlayerRect(playerTransform.pos.x - playerBox.halfSize.x,
-				playerTransform.pos.y - playerBox.halfSize.y,
-				playerBox.size.x, playerBox.size.y);
+		auto hit = Physics::sweep(from, box.halfSize, delta, _sweepBoxes);
+		if (hit.time >= 1.f) {
+			from += delta;
+			break;
+		}
 
-			if (newPlayerRect.intersects(obstacleRect)) {
-				playerTransform.pos = previousPos;
-			}
+		// ran into a body rather than an obstacle: shove it if it's pushable
+		if (hit.index >= _sweepHits.size()) {
+			auto body = _bodies[hit.index - _sweepHits.size()];
+			if (body->hasComponent<CRigidBody>())
+				pushBody(body, hit.normal, tfm.vel);
 		}
+
+		float len = length(delta);
+		float t = std::max(0.f, hit.time - skin / len);
+		from += delta * t;
+
+		// what is left of the move, minus the part heading into the face
+		delta *= 1.f - t;
+		float into = delta.x * hit.normal.x + delta.y * hit.normal.y;
+		delta -= hit.normal * into;
+
+		if (pass == 2)
+			delta = sf::Vector2f(0.f, 0.f);
 	}
+
+	tfm.pos = from;
 }
 
 
@@ -567,11 +614,8 @@ void GameProject::sUpdate(sf::Time dt)
 			if (_switchPlayerCountdown <= 0.0f) {
 				_showSwitchMessage = false;
 				_currentPlayer = 2;
-				resetLapProgress();
-				resetRaceState();
-				m_countdownTime = 3.0f; // Reset countdown
-				m_timerActive = false;
-				_isPaused = false;
+				// back to the start line with player 1's barrel and bone layout
+				restoreSnapshot(_raceStart);
 			}
 		}
 
@@ -610,10 +654,64 @@ void GameProject::sUpdate(sf::Time dt)
 		_worldView.getCenter().y - _worldView.getSize().y / 2.f + 10.f
 	);
 
-	sMovement(dt);
-	adjustPlayerPosition();
-	sAnimation(dt);
+	_scheduler.run(dt);
+
+
+
+
+	//handleBarking();
+
+}
+
+
+void GameProject::registerSystems()
+{
+	// Registration order is the tick order. Systems that only touch the
+	// components they declare may run concurrently with non-conflicting ones;
+	// exclusive systems change structure or scene state and run alone.
+	_scheduler.addSystem<Reads<CInput, CSpin, CAwake>, Writes<CTransform, CRigidBody>>("movement", [this](sf::Time dt) { sMovement(dt); });
+	_scheduler.addSystem<Reads<CState, CBoundingBox>, Writes<CTransform>>("adjustPlayer", [this](sf::Time) { adjustPlayerPosition(); });
+	_scheduler.addSystem<Reads<>, Writes<CAnimation, CSprite>>("animation", [this](sf::Time dt) { sAnimation(dt); });
+	_scheduler.addExclusive("raceClock", [this](sf::Time dt) { sRaceClock(dt); });
+	_scheduler.addSystem<Reads<CTransform>, Writes<CSprite, CState>>("animatePlayer", [this](sf::Time) { annimatePlayer(); });
+	// spawning draws from the shared rng and rewrites _barrels and _bones, which
+	// no component declaration covers; it returns at once after the first tick
+	_scheduler.addExclusive("spawn", [this](sf::Time) { spawnBarrel(); spawnBone(); });
+	_scheduler.addSystem<Reads<CBoundingBox, CAwake>, Writes<CTransform, CRigidBody>>("collisions", [this](sf::Time) { sCollisions(); });
+	_scheduler.addExclusive("bonePickup", [this](sf::Time) { sBonePickup(); });
+	_scheduler.addExclusive("speedBoost", [this](sf::Time dt) { sSpeedBoost(dt); });
+	_scheduler.addExclusive("lapProgress", [this](sf::Time) { checkLapProgress(); });
+}
+
+
+// Which kinds of thing collide with which. Pickups and triggers only report
+// overlaps, every other layer is solid.
+void GameProject::registerCollisionLayers()
+{
+	using L = CollisionLayer;
+
+	_collisions.setSolid(L::Pickup, false);
+	_collisions.setSolid(L::Trigger, false);
+
+	_collisions.set(L::Player, L::Racer);
+	_collisions.set(L::Player, L::Barrel);
+	_collisions.set(L::Player, L::Pickup);
+	_collisions.set(L::Player, L::Wall);
+	_collisions.set(L::Player, L::Trigger);
+
+	_collisions.set(L::Racer, L::Racer);
+	_collisions.set(L::Racer, L::Barrel);
+	_collisions.set(L::Racer, L::Pickup);
+	_collisions.set(L::Racer, L::Wall);
+	_collisions.set(L::Racer, L::Trigger);
+
+	_collisions.set(L::Barrel, L::Barrel);
+	_collisions.set(L::Barrel, L::Wall);
+}
+
 
+void GameProject::sRaceClock(sf::Time dt)
+{
 	if (m_countdownTime > 0.0f)
 	{
 
@@ -656,52 +754,55 @@ void GameProject::sUpdate(sf::Time dt)
 
 		m_countdownText.setFillColor(sf::Color::White);
 	}
+}
 
 
-	annimatePlayer();
-	spawnBarrel();
-	spawnBone();
-	sCollisions();
-
-
+void GameProject::sBonePickup()
+{
 	if (!_player) return;
 
 	auto& playerTransform = _player->getComponent<CTransform>();
 	auto& playerSprite = _player->getComponent<CSprite>();
 
-	for (auto& bone : _bones)
+	// player vs pickup pairs from this tick's broadphase
+	for (auto [a, b] : _broadphase.pairs())
 	{
-		if (!bone->isActive()) continue;
+		auto bone = (a == _player) ? b : (b == _player) ? a : nullptr;
+		if (!bone || !bone->isActive() || bone->getTagId() != Tags::Bone) continue;
 
-		auto& boneTransform = bone->getComponent<CTransform>();
+		bone->destroy();
+		SoundPlayer::getInstance().play("Fart"); // Play fart sound
 
-		float distance = std::hypot(playerTransform.pos.x - boneTransform.pos.x,
-			playerTransform.pos.y - boneTransform.pos.y);
+		// Boost player speed for 2 seconds
+		_playerSpeedBoost = true;
+		_speedBoostTimer = 2.0f;
+		playerTransform.vel.x += (playerTransform.vel.x >= 0) ? 100.0f : -100.0f;
+		playerTransform.vel.y += (playerTransform.vel.y >= 0) ? 50.0f : -50.0f;
 
-		if (distance < 50.0f)
+
+		if (playerTransform.vel.x > 0)
 		{
-			bone->destroy();
-			SoundPlayer::getInstance().play("Fart"); // Play fart sound
+			auto& sr = Assets::getInstance().getSpriteRec("PR_Fart");
+			playerSprite.sprite.setTexture(Assets::getInstance().getTexture("PR_Fart"));
 
-			// Boost player speed for 2 seconds
-			_playerSpeedBoost = true;
-			_speedBoostTimer = 2.0f;
-			playerTransform.vel.x += (playerTransform.vel.x >= 0) ? 100.0f : -100.0f;
-			playerTransform.vel.y += (playerTransform.vel.y >= 0) ? 50.0f : -50.0f;
+		}
+	}
 
+	// snow only drifts while bones are out, one step per bone still there;
+	// handles of collected bones stay in _bones but no longer resolve
+	if (_enableSnow) {
+		for (auto h : _bones)
+			if (_entityManager.get(h))
+				updateSnowflakes();
+	}
+}
 
-			if (playerTransform.vel.x > 0)
-			{
-				auto& sr = Assets::getInstance().getSpriteRec("PR_Fart");
-				playerSprite.sprite.setTexture(Assets::getInstance().getTexture("PR_Fart"));
 
-			}
-		}
+void GameProject::sSpeedBoost(sf::Time dt)
+{
+	if (!_player) return;
 
-		if (_enableSnow) {
-			updateSnowflakes();
-		}
-	}
+	auto& playerSprite = _player->getComponent<CSprite>();
 
 	// Handle speed boost duration
 	if (_playerSpeedBoost)
@@ -719,13 +820,6 @@ void GameProject::sUpdate(sf::Time dt)
 			playerSprite.sprite.setTextureRect(sr.texRect);
 		}
 	}
-	checkLapProgress();
-
-
-
-
-	//handleBarking();
-
 }
 
 
@@ -756,7 +850,7 @@ void GameProject::registerActions()
 
 void GameProject::spawnPlayer(sf::Vector2f pos)
 {
-	_player = _entityManager.addEntity("player");
+	_player = _entityManager.addEntity(Tags::Player);
 	_player->addComponent<CTransform>(pos);
 
 	auto& sr = Assets::getInstance().getSpriteRec("PugLeft");
@@ -764,8 +858,8 @@ void GameProject::spawnPlayer(sf::Vector2f pos)
 	sprite.setTextureRect(sr.texRect);
 	centerOrigin(sprite);
 
-	_player->addComponent<CBoundingBox>(sf::Vector2f{ 64.f,64.f });
-	_player->addComponent<CState>("straight");
+	_player->addComponent<CBoundingBox>(sf::Vector2f{ 64.f,64.f }, CollisionLayer::Player);
+	_player->addComponent<CState>(State::Straight);
 	_player->addComponent<CInput>();
 }
 
@@ -788,21 +882,10 @@ void GameProject::playerMovement()
 
 	playerVel = _config.playerSpeed * normalize(playerVel);
 
-	auto& playerPos = _player->getComponent<CTransform>().pos;
-	sf::Vector2u imageSize = _backgroundImage.getSize();
-	unsigned int px = static_cast<unsigned int>(playerPos.x);
-	unsigned int py = static_cast<unsigned int>(playerPos.y);
-
-
-	if (px < imageSize.x && py < imageSize.y) {
-		sf::Color pixelColor = _backgroundImage.getPixel(px, py);
-
-		// Range green
-		if (pixelColor.r >= 15 && pixelColor.r <= 30 &&
-			pixelColor.g >= 210 && pixelColor.g <= 230 &&
-			pixelColor.b >= 20 && pixelColor.b <= 35) {
-			playerVel *= 0.5f;
-		}
+	// grass slows the pug down, walls only ever sit on grass
+	auto ground = _level.terrain.at(_player->getComponent<CTransform>().pos);
+	if (ground == Terrain::Grass || ground == Terrain::Wall) {
+		playerVel *= 0.5f;
 	}
 	_player->getComponent<CTransform>().vel = playerVel;
 }
@@ -817,28 +900,28 @@ void GameProject::annimatePlayer()
 
 	if (playerVel.x < -0.1f)
 	{
-		playerState = "left";
+		playerState = State::Left;
 		auto& sr = Assets::getInstance().getSpriteRec("PugLeft");
 		playerSprite.setTexture(Assets::getInstance().getTexture(sr.texName));
 		playerSprite.setTextureRect(sr.texRect);
 	}
 	else if (playerVel.x > 0.1f)
 	{
-		playerState = "right";
+		playerState = State::Right;
 		auto& sr = Assets::getInstance().getSpriteRec("PugRight");
 		playerSprite.setTexture(Assets::getInstance().getTexture(sr.texName));
 		playerSprite.setTextureRect(sr.texRect);
 	}
 	else if (playerVel.y < -0.1f)
 	{
-		playerState = "up";
+		playerState = State::Up;
 		auto& sr = Assets::getInstance().getSpriteRec("PugUp");
 		playerSprite.setTexture(Assets::getInstance().getTexture(sr.texName));
 		playerSprite.setTextureRect(sr.texRect);
 	}
 	else if (playerVel.y > 0.1f)
 	{
-		playerState = "down";
+		playerState = State::Down;
 		auto& sr = Assets::getInstance().getSpriteRec("PugDown");
 		playerSprite.setTexture(Assets::getInstance().getTexture(sr.texName));
 		playerSprite.setTextureRect(sr.texRect);
@@ -852,70 +935,23 @@ void GameProject::annimatePlayer()
 
 void GameProject::spawnBarrel()
 {
-
 	if (_barrelsSpawned) return;
 
 	_barrels.clear();
-	int mapWidth, mapHeight;
-	sf::Image* selectedBackground;
-
-	// Determine which background is being used
-	if (_levelPath.find("level2.txt") != std::string::npos) {
-		selectedBackground = &_backgroundImageBeach;
-	}
-	else if (_levelPath.find("level3.txt") != std::string::npos) {
-		selectedBackground = &_backgroundImageSnow;
-	}
-	else {
-		selectedBackground = &_backgroundImage;
-	}
-
-	mapWidth = selectedBackground->getSize().x;
-	mapHeight = selectedBackground->getSize().y;
-
-	std::uniform_int_distribution<int> distX(0, mapWidth - 1);
-	std::uniform_int_distribution<int> distY(0, mapHeight - 1);
-
-	for (int i = 0; i < 3; ++i) {
-		bool validSpawn = false;
-		int x, y;
-
-		while (!validSpawn) {
-			x = distX(rng);
-			y = distY(rng);
-
-			if (x < mapWidth && y < mapHeight) {
-				sf::Color pixelColor = selectedBackground->getPixel(x, y);
-
-				if ((selectedBackground == &_backgroundImage && pixelColor.r == 66 && pixelColor.g == 80 && pixelColor.b == 86) ||
-					(selectedBackground == &_backgroundImageBeach && pixelColor.r == 66 && pixelColor.g == 80 && pixelColor.b == 86) ||
-					(selectedBackground == &_backgroundImageSnow && pixelColor.r == 100 && pixelColor.g == 103 && pixelColor.b == 100)) {
-					validSpawn = true;
-				}
-			}
-		}
-
-		auto barrel = _entityManager.addEntity("Barrel");
-		if (barrel->hasComponent<CSprite>()) {
-			auto& sprite = barrel->getComponent<CSprite>();
-
-			sf::Vector2u textureSize = sprite.sprite.getTexture()->getSize();
-
 
+	// spread out so they don't start stacked on one another
+	_spawnPoints.clear();
+	_level.spawns.sample(_levelData.barrels.count, _levelData.barrels.spacing, rng, _spawnPoints);
 
-		}
-		barrel->addComponent<CBoundingBox>(sf::Vector2f{ 64.f,64.f });
-		barrel->addComponent<CTransform>(sf::Vector2f(x, y));
-		barrel->addComponent<CSprite>(Assets::getInstance().getTexture("Barrel"));
-		/*barrel->addComponent<CCollision>();*/
-		_barrels.push_back(barrel);
+	for (auto p : _spawnPoints) {
+		// deferred to the next EntityManager::update, which fills in _barrels
+		_entityManager.commands().create(Tags::Barrel, &_barrels)
+			.with<CBoundingBox>(sf::Vector2f{ 64.f,64.f }, CollisionLayer::Barrel)
+			.with<CTransform>(p)
+			.with<CSprite>(Assets::getInstance().getTexture("Barrel"))
+			.with<CRigidBody>(2.f, 0.4f, 2.5f);	// starts asleep, no CAwake until bumped
 	}
 	_barrelsSpawned = true;
-
-
-
-
-
 }
 
 void GameProject::spawnBone()
@@ -923,50 +959,16 @@ void GameProject::spawnBone()
 	if (_bonesSpawned) return;
 
 	_bones.clear();
-	int mapWidth, mapHeight;
-	sf::Image* selectedBackground;
-
-	// Determine which background is being used
-	if (_levelPath.find("level2.txt") != std::string::npos) {
-		selectedBackground = &_backgroundImageBeach;
-	}
-	else if (_levelPath.find("level3.txt") != std::string::npos) {
-		selectedBackground = &_backgroundImageSnow;
-	}
-	else {
-		selectedBackground = &_backgroundImage;
-	}
-
-	mapWidth = selectedBackground->getSize().x;
-	mapHeight = selectedBackground->getSize().y;
-
-	std::uniform_int_distribution<int> distX(0, mapWidth - 1);
-	std::uniform_int_distribution<int> distY(0, mapHeight - 1);
-
-	for (int i = 0; i < 5; ++i) {
-		bool validSpawn = false;
-		int x, y;
 
-		while (!validSpawn) {
-			x = distX(rng);
-			y = distY(rng);
+	_spawnPoints.clear();
+	_level.spawns.sample(_levelData.bones.count, _levelData.bones.spacing, rng, _spawnPoints);
 
-			if (x < mapWidth && y < mapHeight) {
-				sf::Color pixelColor = selectedBackground->getPixel(x, y);
-
-				// Ensure the bone spawns on the track
-				if ((selectedBackground == &_backgroundImage && pixelColor.r == 66 && pixelColor.g == 80 && pixelColor.b == 86) ||
-					(selectedBackground == &_backgroundImageBeach && pixelColor.r == 66 && pixelColor.g == 80 && pixelColor.b == 86) ||
-					(selectedBackground == &_backgroundImageSnow && pixelColor.r == 100 && pixelColor.g == 103 && pixelColor.b == 100)) {
-					validSpawn = true;
-				}
-			}
-		}
-
-		auto bone = _entityManager.addEntity("Bone");
-		bone->addComponent<CTransform>(sf::Vector2f(x, y));
-		bone->addComponent<CSprite>(Assets::getInstance().getTexture("Bone"));
-		_bones.push_back(bone);
+	for (auto p : _spawnPoints) {
+		_entityManager.commands().create(Tags::Bone, &_bones)
+			.with<CTransform>(p)
+			.with<CSprite>(Assets::getInstance().getTexture("Bone"))
+			// picked up when the pug's box comes within 50px of its centre on both axes
+			.with<CBoundingBox>(sf::Vector2f{ 36.f,36.f }, CollisionLayer::Pickup);
 	}
 
 	_bonesSpawned = true;
@@ -980,11 +982,14 @@ void GameProject::handleBarking()
 	sf::Vector2f playerPos = _player->getComponent<CTransform>().pos;
 
 	// Find the nearest barrel
-	std::shared_ptr<Entity> nearestBarrel = nullptr;
+	EntityHandle nearestBarrel;
 	float nearestDistance = std::numeric_limits<float>::max();
 
-	for (auto& barrel : _barrels)
+	for (auto& handle : _barrels)
 	{
+		auto barrel = _entityManager.get(handle);
+		if (!barrel) continue;
+
 		sf::Vector2f barrelPos = barrel->getComponent<CTransform>().pos;
 
 		// Calculate distance between player and barrel using Pythagorean theorem
@@ -994,18 +999,19 @@ void GameProject::handleBarking()
 		if (distance < nearestDistance)
 		{
 			nearestDistance = distance;
-			nearestBarrel = barrel;
+			nearestBarrel = handle;
 		}
 	}
 
 	// Check if player is close enough (within trigger distance) and presses "E"
 	float triggerDistance = 150.f;
 
-	if (nearestBarrel && nearestDistance <= triggerDistance)
+	auto barrel = _entityManager.get(nearestBarrel);
+	if (barrel && nearestDistance <= triggerDistance)
 	{
 		if (sf::Keyboard::isKeyPressed(sf::Keyboard::E))  // Check for "E" key press
 		{
-			sf::Vector2f explosionPos = nearestBarrel->getComponent<CTransform>().pos;
+			sf::Vector2f explosionPos = barrel->getComponent<CTransform>().pos;
 
 			// Remove the nearest barrel from the list
 			auto it = std::find(_barrels.begin(), _barrels.end(), nearestBarrel);
@@ -1015,7 +1021,7 @@ void GameProject::handleBarking()
 			}
 
 			// Destroy the barrel entity
-			nearestBarrel->destroy();
+			barrel->destroy();
 
 			// Play random explosion sound
 			std::uniform_int_distribution<int> flip(1, 2);
@@ -1025,7 +1031,7 @@ void GameProject::handleBarking()
 				SoundPlayer::getInstance().play("Explosion2", explosionPos);
 
 			// Spawn explosion animation
-			auto explosion = _entityManager.addEntity("Explosion");
+			auto explosion = _entityManager.addEntity(Tags::Explosion);
 			explosion->addComponent<CTransform>(explosionPos);
 			startAnimation(explosion, "Explosion"); // Start animation
 		}
@@ -1033,7 +1039,7 @@ void GameProject::handleBarking()
 }
 
 
-void GameProject::startAnimation(sPtrEntt e, std::string animation) {
+void GameProject::startAnimation(EntityPtr e, std::string animation) {
 	auto& animComp = e->addComponent<CAnimation>();
 	auto& animRec = Assets::getInstance().getAnimationRec(animation);
 
@@ -1057,7 +1063,7 @@ void GameProject::startAnimation(sPtrEntt e, std::string animation) {
 void GameProject::adjustPlayerPosition()
 {
 	// don't ajust position if dead
-	if (_player->getComponent<CState>().state == "dead")
+	if (_player->getComponent<CState>().state == State::Dead)
 		return;
 
 	auto center = _worldView.getCenter();
@@ -1080,12 +1086,21 @@ void GameProject::adjustPlayerPosition()
 
 void GameProject::init(const std::string& levelPath)
 {
-	_backgroundImage = Assets::getInstance().getTexture("Park").copyToImage();
-	_backgroundImageBeach = Assets::getInstance().getTexture("Beach").copyToImage();
-	_backgroundImageSnow = Assets::getInstance().getTexture("Snow").copyToImage();
+	// pre-warm the entity pool so the spawn bursts at race start and on player
+	// switch reuse slots and component storage instead of allocating
+	_entityManager.reserve<CTransform, CSprite, CAnimation>(Tags::Explosion, 64);
+	_entityManager.reserve<CTransform, CSprite, CBoundingBox, CRigidBody, CAwake>(Tags::Barrel, 16);
+	_entityManager.reserve<CTransform, CSprite, CBoundingBox>(Tags::Bone, 16);
+
 	loadLevel(levelPath);
+	_barrels.reserve(_levelData.barrels.count);
+	_bones.reserve(_levelData.bones.count);
+	_spawnPoints.reserve(std::max(_levelData.barrels.count, _levelData.bones.count));
+
 	generateBlockingSquares();
 	registerActions();
+	registerCollisionLayers();
+	registerSystems();
 
 	initUI();
 
@@ -1096,9 +1111,6 @@ void GameProject::init(const std::string& levelPath)
 	//spawnPlayer(spawnPos);
 
 
-	initSnowflakes(100);
-
-
 	MusicPlayer::getInstance().play("gameTheme");
 	MusicPlayer::getInstance().setVolume(5);
 
@@ -1118,7 +1130,7 @@ void GameProject::init(const std::string& levelPath)
 	m_countdownText.setString(std::to_string(static_cast<int>(m_countdownTime))); // Initial display
 
 
-	setupCheckpoints(levelPath);
+	setupCheckpoints();
 
 
 
@@ -1128,48 +1140,28 @@ void GameProject::init(const std::string& levelPath)
 
 }
 
+// Level files are compiled into ../cache on first load, see LevelData.
 void GameProject::loadLevel(const std::string& path)
 {
-	std::ifstream config(path);
-
-	if (config.fail()) {
-		std::cerr << "Open file " << path << " failed\n";
-		config.close();
+	auto compiledPath = "../cache/" + std::filesystem::path(path).stem().string() + ".level";
+	if (!_levelData.load(path, compiledPath)) {
+		std::cerr << "Level " << path << " failed to load\n";
 		exit(1);
 	}
 
-	std::string token{ "" };
-
-
-	config >> token;
-	while (!config.eof()) {
-		if (token == "Bkg") {
-			std::string name;
-			sf::Vector2f pos;
-			config >> name >> pos.x >> pos.y;
-
-			auto e = _entityManager.addEntity("bkg");
+	_worldBounds.width = _levelData.world.x;
+	_worldBounds.height = _levelData.world.y;
+	_config.playerSpeed = _levelData.playerSpeed;
 
-			/*generateBlockingSquares();*/
+	if (!_levelData.bkgName.empty()) {
+		auto e = _entityManager.addEntity(Tags::Bkg);
 
-			// for background, no textureRect its just the whole texture
-			// and no center origin, position by top left corner
-			auto& sprite = e->addComponent<CSprite>(Assets::getInstance().getTexture(name)).sprite;
-			sprite.setOrigin(0.f, 0.f);
-			sprite.setPosition(pos);
-
-
-		}
-		else if (token == "World") {
-			config >> _worldBounds.width >> _worldBounds.height;
-		}
-		else if (token == "PlayerSpeed") {
-			config >> _config.playerSpeed;
-		}
-		config >> token;
+		// for background, no textureRect its just the whole texture
+		// and no center origin, position by top left corner
+		auto& sprite = e->addComponent<CSprite>(Assets::getInstance().getTexture(_levelData.bkgName)).sprite;
+		sprite.setOrigin(0.f, 0.f);
+		sprite.setPosition(_levelData.bkgPos);
 	}
-
-	config.close();
 }
 
 void GameProject::update(sf::Time dt)
@@ -1235,22 +1227,7 @@ void GameProject::onEnd() {
 }
 void GameProject::spawnPlayerForLevel()
 {
-	sf::Vector2f startPosition;
-
-	if (_levelPath.find("level1.txt") != std::string::npos) {
-		startPosition = sf::Vector2f(646.f, 442.f);
-	}
-	else if (_levelPath.find("level2.txt") != std::string::npos) {
-		startPosition = sf::Vector2f(170.f, 706.f);
-	}
-	else if (_levelPath.find("level3.txt") != std::string::npos) {
-		startPosition = sf::Vector2f(184.f, 586.f);
-	}
-	else {
-		startPosition = sf::Vector2f(100.f, 500.f);
-	}
-
-	spawnPlayer(startPosition);
+	spawnPlayer(_levelData.start);
 }
 
 
@@ -1259,21 +1236,18 @@ void GameProject::sRender()
 	_game->window().setView(_worldView);
 
 	// Draw background first
-	for (auto e : _entityManager.getEntities("bkg")) {
-		if (e->getComponent<CSprite>().has) {
+	for (auto e : _entityManager.getEntities(Tags::Bkg)) {
+		if (e->hasComponent<CSprite>()) {
 			auto& sprite = e->getComponent<CSprite>().sprite;
 			_game->window().draw(sprite);
 		}
 	}
 
 	// Draw entities (excluding background)
-	for (auto& e : _entityManager.getEntities()) {
-		if (!e->hasComponent<CSprite>() || e->getTag() == "bkg")
-			continue;
-
+	// the background has no CTransform so the view skips it
+	for (auto [e, spriteComp, tfm] : _entityManager.view<CSprite, CTransform>()) {
 		// Draw Sprite
-		auto& sprite = e->getComponent<CSprite>().sprite;
-		auto& tfm = e->getComponent<CTransform>();
+		auto& sprite = spriteComp.sprite;
 		sprite.setPosition(tfm.pos);
 		sprite.setRotation(tfm.angle);
 		_game->window().draw(sprite);
@@ -1284,7 +1258,7 @@ void GameProject::sRender()
 			sf::RectangleShape rect;
 			rect.setSize(sf::Vector2f{ box.size.x, box.size.y });
 			centerOrigin(rect);
-			rect.setPosition(e->getComponent<CTransform>().pos);
+			rect.setPosition(tfm.pos);
 			rect.setFillColor(sf::Color(0, 0, 0, 0));
 			rect.setOutlineColor(sf::Color{ 0, 255, 0 });
 			rect.setOutlineThickness(2.f);
@@ -1292,9 +1266,13 @@ void GameProject::sRender()
 		}
 	}
 
-	// Draw obstacles
-	for (const auto& obstacle : obstacles)
+	// Draw obstacles, only the ones in view
+	sf::FloatRect viewRect(_worldView.getCenter() - _worldView.getSize() / 2.f, _worldView.getSize());
+	_visibleObstacles.clear();
+	_level.obstacleGrid.query(viewRect, _visibleObstacles);
+	for (auto i : _visibleObstacles)
 	{
+		const auto& obstacle = _level.obstacles[i];
 		// Draw the visual representation (larger)
 		sf::RectangleShape visualBlock(sf::Vector2f(10, 10)); // Original BLOCK_SIZE
 		visualBlock.setPosition(obstacle.x - (10 - obstacle.width) / 2, obstacle.y - (10 - obstacle.height) / 2);
@@ -1,28 +1,21 @@
 #pragma once
 
 #include "Scene.h"
+#include "SystemScheduler.h"
+#include "Snapshot.h"
+#include "LevelGeometry.h"
+#include "LevelData.h"
+#include "Physics.h"
+#include "Broadphase.h"
 #include <queue>
 
 
 struct Checkpoint {
     sf::FloatRect area;
     bool reached = false;
+    float bonus = 0.f;
 };
 
-struct BlockingSquare {
-    //int x, y;
-    //int width = 10;  // Default size of the blocking square
-    //int height = 10;
-    //sf::FloatRect bounds;
-
-    int x;
-    int y;
-    int width;
-    int height;
-
-};
-
-
 //struct BlockingSquare {
 //    int x, y;
 //    int width = 10;  // Default size of the blocking square
@@ -40,8 +33,6 @@ void generateBlockingSquares();
 
 
 
-extern std::vector<BlockingSquare> obstacles;
-
 struct PlayerRecord {
     float lapTime;
     std::string playerName;
@@ -66,7 +57,7 @@ struct LevelConfig {
 class GameProject : public Scene
 {
     GameEngine* m_game;
-    sPtrEntt                        _player{ nullptr };
+    EntityPtr                       _player{ nullptr };
     sf::View                        _worldView;
     sf::FloatRect                   _worldBounds;
     int                             _barkCounter{ 2 };
@@ -74,6 +65,7 @@ class GameProject : public Scene
 
 
     LevelConfig                     _config;
+    SystemScheduler                 _scheduler;
 
     bool                            _drawTextures{ true };
     bool                            _drawAABB{ false };
@@ -82,6 +74,17 @@ class GameProject : public Scene
     float _lastLapTime = 0.0f;  // Stores last completed lap time
     int _lapCount = 0;
 
+    LevelGeometry           _level;             // terrain, obstacles and wall field from the background
+    std::vector<sf::Vector2f> _spawnPoints;     // spawnBarrel/spawnBone scratch
+    std::vector<uint32_t>   _visibleObstacles;  // query scratch for sRender
+    Physics::AABBs          _bodyBoxes;         // sCollisions scratch: bodies the player can bump into
+    EntityVec               _bodies;            // owner of _bodyBoxes[i]
+    Physics::Overlaps       _bodyOverlaps;
+    CollisionMatrix         _collisions;        // layer vs layer, see registerCollisionLayers
+    SortAndSweep            _broadphase;        // overlapping body pairs, for body vs body collision and pickups
+    Physics::AABBs          _sweepBoxes;        // sweepPlayer scratch: candidates for this move
+    std::vector<uint32_t>   _sweepHits;
+
     std::vector<Checkpoint> _checkpoints;
     sf::FloatRect _finishLine;
     int _currentCheckpoint = 0;
@@ -91,20 +94,31 @@ class GameProject : public Scene
 
     void checkLapProgress();
 
-    void setupCheckpoints(const std::string& levelPath);
+    void setupCheckpoints();
 
-    void resetLapProgress();
     void generateBlockingSquares();
     void initializeObstacles();
     void initializeCheckpoints();
     void updateUI();
-    void resetRaceState();
+
+    // Snapshot of the world at race start, restored to hand over to player 2.
+    // Cheap enough to take every tick for rollback or replay seeking.
+    Snapshot                _raceStart;
+    void                    saveSnapshot(Snapshot& snap) const;
+    void                    restoreSnapshot(Snapshot& snap);
 
     //systems
     void                    sAnimation(sf::Time dt);
     void                    sMovement(sf::Time dt);
     void                    sCollisions();
+    void                    sweepPlayer(CTransform& tfm, const CBoundingBox& box);
+    void                    integrateBodies(sf::Time dt);
+    void                    pushBody(EntityPtr body, const sf::Vector2f& normal, const sf::Vector2f& pusherVel);
+    void                    wakeBody(EntityPtr body);
     void                    sUpdate(sf::Time dt);
+    void                    sRaceClock(sf::Time dt);
+    void                    sBonePickup();
+    void                    sSpeedBoost(sf::Time dt);
     void	                onEnd() override;
     void                    sSpawnEnemies();
     void                    onBark();
@@ -114,13 +128,15 @@ class GameProject : public Scene
     // helper functions
 //  //  void spawnBarrels();
     void checkBarkCollision();
-    void startAnimation(sPtrEntt e, std::string animation);
-    // void                    startAnimation(sPtrEntt e, std::string animation);
-    void                    checkIfDead(sPtrEntt e);
+    void startAnimation(EntityPtr e, std::string animation);
+    // void                    startAnimation(EntityPtr e, std::string animation);
+    void                    checkIfDead(EntityPtr e);
     void                    checkPlayerCollision();
     void                    destroyOutsideWindow();
     void                    spawnEnemy(SpawnPoint sp);
     void	                registerActions();
+    void                    registerSystems();
+    void                    registerCollisionLayers();
     void                    spawnPlayer(sf::Vector2f pos);
     void                    playerMovement();
     void                    annimatePlayer();
@@ -135,10 +151,10 @@ class GameProject : public Scene
 
     //  std::vector<std::shared_ptr<Entity>> _obstacles;
 
-    std::vector<std::shared_ptr<Entity>> _barrels;
+    std::vector<EntityHandle> _barrels;
     bool _barrelsSpawned = false;
 
-    std::vector<std::shared_ptr<Entity>> _bones;
+    std::vector<EntityHandle> _bones;
     bool _bonesSpawned = false;
 
     float m_countdownTime = 3.0f; // Countdown before race starts
@@ -147,10 +163,9 @@ class GameProject : public Scene
 
     //sf::Text _timerText;
     sf::Text m_countdownText;
-    std::shared_ptr<Entity> _backgroundEntity;
-    sf::Image _backgroundImage;
-    sf::Image _backgroundImageBeach;
-    sf::Image _backgroundImageSnow;
+    EntityHandle _backgroundEntity;
+
+    LevelData               _levelData;         // as read by loadLevel
 
     bool _playerSpeedBoost = false;
     float _speedBoostTimer = 0.0f;
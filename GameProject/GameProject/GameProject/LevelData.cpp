@@ -0,0 +1,226 @@
+#include "LevelData.h"
+#include "MappedFile.h"
+#include "Snapshot.h"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <filesystem>
+
+
+namespace {
+    constexpr uint32_t  LevelMagic = 0x56475550;    // "PUGV"
+
+    // out of range channels fail the stream like any other bad number
+    sf::Color readColour(std::istream& in) {
+        int c[3]{ 0, 0, 0 };
+        for (auto& v : c) {
+            in >> v;
+            if (v < 0 || v > 255)
+                in.setstate(std::ios::failbit);
+        }
+        return sf::Color(static_cast<sf::Uint8>(c[0]), static_cast<sf::Uint8>(c[1]), static_cast<sf::Uint8>(c[2]));
+    }
+
+    // >> into an unsigned wraps a minus sign around instead of failing
+    uint32_t readCount(std::istream& in) {
+        long long n{ 0 };
+        in >> n;
+        if (n < 0 || n > UINT32_MAX)
+            in.setstate(std::ios::failbit);
+        return static_cast<uint32_t>(n);
+    }
+
+    sf::FloatRect readRect(std::istream& in) {
+        sf::FloatRect r;
+        in >> r.left >> r.top >> r.width >> r.height;
+        return r;
+    }
+
+    // strings go as a char array, Snapshot only copies plain data
+    void writeString(Snapshot& out, const std::string& s) {
+        out.writeArray(std::vector<char>(s.begin(), s.end()));
+    }
+
+    void readString(ByteReader& in, std::string& s) {
+        std::vector<char> chars;
+        in.readArray(chars);
+        s.assign(chars.begin(), chars.end());
+    }
+}
+
+
+bool LevelData::load(const std::string& textPath, const std::string& compiledPath) {
+    auto stamp = sourceStamp(textPath);
+    if (stamp == 0)
+        return loadCompiled(compiledPath, 0);
+
+    if (loadCompiled(compiledPath, stamp))
+        return true;
+
+    std::ifstream text(textPath);
+    *this = LevelData();
+    if (!parse(text, textPath)) {
+        *this = LevelData();
+        return false;
+    }
+
+    saveCompiled(compiledPath, stamp);
+    return true;
+}
+
+
+bool LevelData::parse(std::istream& text, const std::string& name) {
+    if (!text) {
+        std::cerr << name << ": can't be read\n";
+        return false;
+    }
+
+    std::string line;
+    for (int number = 1; std::getline(text, line); ++number) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream in(line);
+        std::string token;
+        if (!(in >> token))
+            continue;
+
+        if (token == "World") {
+            in >> world.x >> world.y;
+        }
+        else if (token == "PlayerSpeed") {
+            in >> playerSpeed;
+        }
+        else if (token == "Bkg") {
+            in >> bkgName >> bkgPos.x >> bkgPos.y;
+        }
+        else if (token == "Terrain") {
+            in >> terrainPath;
+        }
+        else if (token == "Road") {
+            colours.road = readColour(in);
+        }
+        else if (token == "Grass") {
+            colours.grassMin = readColour(in);
+            colours.grassMax = readColour(in);
+        }
+        else if (token == "Checkpoint") {
+            LevelCheckpoint checkpoint;
+            checkpoint.area = readRect(in);
+            in >> checkpoint.bonus;
+            checkpoints.push_back(checkpoint);
+        }
+        else if (token == "Finish") {
+            finishLine = readRect(in);
+        }
+        else if (token == "Start") {
+            in >> start.x >> start.y;
+        }
+        else if (token == "Barrels") {
+            barrels.count = readCount(in);
+            in >> barrels.spacing;
+        }
+        else if (token == "Bones") {
+            bones.count = readCount(in);
+            in >> bones.spacing;
+        }
+        else if (token == "Snow") {
+            snowflakes = readCount(in);
+        }
+        else {
+            std::cerr << name << ":" << number << ": unknown directive " << token << "\n";
+            return false;
+        }
+
+        // every field read, and nothing left over
+        std::string extra;
+        if (in.fail() || in >> extra) {
+            std::cerr << name << ":" << number << ": malformed " << token << ": " << line << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+
+uint64_t LevelData::sourceStamp(const std::string& textPath) {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(textPath, ec);
+    if (ec)
+        return 0;
+    auto time = std::filesystem::last_write_time(textPath, ec);
+    if (ec)
+        return 0;
+
+    auto ticks = static_cast<uint64_t>(time.time_since_epoch().count());
+    return (ticks * 1099511628211ull) ^ size ^ 1;     // never 0, 0 means no text
+}
+
+
+// stamp 0 takes whatever compiled copy there is
+bool LevelData::loadCompiled(const std::string& path, uint64_t stamp) {
+    MappedFile file;
+    if (!file.open(path))
+        return false;
+
+    ByteReader in(file.data(), file.size());
+    uint32_t magic{ 0 }, version{ 0 };
+    uint64_t fileStamp{ 0 };
+    in.read(magic);
+    in.read(version);
+    in.read(fileStamp);
+    if (!in.ok() || magic != LevelMagic || version != Version || (stamp != 0 && fileStamp != stamp))
+        return false;
+
+    LevelData level;
+    in.read(level.world);
+    in.read(level.playerSpeed);
+    readString(in, level.bkgName);
+    in.read(level.bkgPos);
+    readString(in, level.terrainPath);
+    in.read(level.colours);
+    in.readArray(level.checkpoints);
+    in.read(level.finishLine);
+    in.read(level.start);
+    in.read(level.barrels);
+    in.read(level.bones);
+    in.read(level.snowflakes);
+    if (!in.ok())
+        return false;
+
+    *this = std::move(level);
+    return true;
+}
+
+
+bool LevelData::saveCompiled(const std::string& path, uint64_t stamp) const {
+    Snapshot out;
+    out.write(LevelMagic);
+    out.write(Version);
+    out.write(stamp);
+    out.write(world);
+    out.write(playerSpeed);
+    writeString(out, bkgName);
+    out.write(bkgPos);
+    writeString(out, terrainPath);
+    out.write(colours);
+    out.writeArray(checkpoints);
+    out.write(finishLine);
+    out.write(start);
+    out.write(barrels);
+    out.write(bones);
+    out.write(snowflakes);
+
+    std::error_code ec;
+    auto dir = std::filesystem::path(path).parent_path();
+    if (!dir.empty())
+        std::filesystem::create_directories(dir, ec);
+
+    auto tmp = path + ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        if (!file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size())))
+            return false;
+    }
+    std::filesystem::rename(tmp, path, ec);
+    return !ec;
+}
@@ -0,0 +1,73 @@
+#ifndef BREAKOUT_LEVELDATA_H
+#define BREAKOUT_LEVELDATA_H
+
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <istream>
+
+#include <SFML/Graphics.hpp>
+
+#include "LevelGeometry.h"
+
+
+struct LevelCheckpoint {
+    sf::FloatRect   area;
+    float           bonus{ 0.f };   // seconds added to the race clock on reaching it
+};
+
+struct SpawnRule {
+    uint32_t        count{ 0 };
+    float           spacing{ 0.f }; // minimum distance between any two, see SpawnTable::sample
+};
+
+
+// Everything a level file describes. The text form is what gets edited:
+//
+//      World w h                   PlayerSpeed s
+//      Bkg name x y                Terrain path
+//      Road r g b                  Grass r g b r g b   (lowest, then highest)
+//      Checkpoint x y w h bonus    one per checkpoint, in the order they're run
+//      Finish x y w h              Start x y
+//      Barrels count spacing       Bones count spacing
+//      Snow count                  # to the end of the line is a comment
+//
+// Every text file also gets a compiled copy, the same fields as plain bytes,
+// which is what a run normally loads. It records the size and write time of
+// the text it was compiled from and is rebuilt when either changes. With the
+// text file gone the compiled copy is used as it is, so a track can be
+// swapped by dropping in just its .level file.
+struct LevelData {
+    static constexpr uint32_t       Version = 1;    // bump when the fields or their order change
+
+    sf::Vector2f                    world;
+    float                           playerSpeed{ 200.f };
+    std::string                     bkgName;
+    sf::Vector2f                    bkgPos;
+    std::string                     terrainPath;    // the image terrain, obstacles and spawns come from
+    SurfaceColours                  colours;
+    std::vector<LevelCheckpoint>    checkpoints;
+    sf::FloatRect                   finishLine;
+    sf::Vector2f                    start{ 100.f, 500.f };
+    SpawnRule                       barrels{ 3, 256.f };
+    SpawnRule                       bones{ 5, 160.f };
+    uint32_t                        snowflakes{ 0 };
+
+    // From the compiled copy when it's current, else from the text, which is
+    // then compiled for next time. False if neither could be read, or the
+    // text doesn't parse; nothing is compiled then.
+    bool                            load(const std::string& textPath, const std::string& compiledPath);
+
+    // One directive per line. Stops at the first line that is unknown, short
+    // of a field or has one too many, and reports it as name:line on stderr.
+    bool                            parse(std::istream& in, const std::string& name);
+    bool                            loadCompiled(const std::string& path, uint64_t stamp);
+    bool                            saveCompiled(const std::string& path, uint64_t stamp) const;
+
+    // size and write time of a text file, 0 if it can't be read
+    static uint64_t                 sourceStamp(const std::string& textPath);
+};
+
+
+#endif //BREAKOUT_LEVELDATA_H
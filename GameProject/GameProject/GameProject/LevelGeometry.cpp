@@ -0,0 +1,317 @@
+#include "LevelGeometry.h"
+#include "MappedFile.h"
+#include "Snapshot.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+
+
+namespace {
+    constexpr uint32_t  CacheMagic = 0x4C475550;    // "PUGL"
+
+    // FNV-1a, a word at a time rather than a byte
+    constexpr uint64_t  FnvOffset = 14695981039346656037ull;
+    constexpr uint64_t  FnvPrime = 1099511628211ull;
+
+    inline uint64_t mix(uint64_t h, uint64_t word) {
+        return (h ^ word) * FnvPrime;
+    }
+
+    uint64_t mixBytes(uint64_t h, const uint8_t* bytes, size_t size) {
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            uint64_t word;
+            std::memcpy(&word, bytes + i, 8);
+            h = mix(h, word);
+        }
+        for (; i < size; ++i)
+            h = mix(h, bytes[i]);
+        return h;
+    }
+
+    // everything but the image that shapes what build() makes
+    uint64_t keyBase(const SurfaceColours& colours) {
+        uint64_t h = FnvOffset;
+        for (uint64_t v : { uint64_t(LevelGeometry::CacheVersion), uint64_t(LevelGeometry::StepSize),
+            uint64_t(LevelGeometry::BlockSize), uint64_t(LevelGeometry::CollisionSize), uint64_t(LevelGeometry::BoundaryOffset),
+            uint64_t(LevelGeometry::GrassMargin), uint64_t(LevelGeometry::TerrainCellSize) })
+            h = mix(h, v);
+
+        for (auto c : { colours.road, colours.grassMin, colours.grassMax })
+            h = mix(h, c.toInteger());
+        return h;
+    }
+}
+
+
+Terrain SurfaceColours::classify(sf::Color c) const {
+    if (isRoad(c))
+        return Terrain::Track;
+
+    if (c.r >= grassMin.r && c.r <= grassMax.r &&
+        c.g >= grassMin.g && c.g <= grassMax.g &&
+        c.b >= grassMin.b && c.b <= grassMax.b)
+        return Terrain::Grass;
+
+    return Terrain::Open;
+}
+
+
+// Each run of neighbouring blocks is grown right as far as it goes, then down
+// while every block under the run is still unclaimed, and becomes one obstacle
+// covering the collision boxes (size x size, inset into each block) of all
+// the blocks it swallowed.
+std::vector<BlockingSquare> mergeBlocks(const BlockPositions& blocks, int pitch, int inset, int size) {
+    std::vector<BlockingSquare> merged;
+    if (blocks.empty())
+        return merged;
+
+    int minX = blocks.begin()->first, maxX = minX;
+    int minY = blocks.begin()->second, maxY = minY;
+    for (const auto& [x, y] : blocks) {
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+    }
+
+    int cols = (maxX - minX) / pitch + 1;
+    int rows = (maxY - minY) / pitch + 1;
+    std::vector<uint8_t> pending(static_cast<size_t>(cols) * rows, 0);
+    for (const auto& [x, y] : blocks)
+        pending[((y - minY) / pitch) * cols + (x - minX) / pitch] = 1;
+
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            if (!pending[r * cols + c])
+                continue;
+
+            int w = 1;
+            while (c + w < cols && pending[r * cols + c + w])
+                ++w;
+
+            int h = 1;
+            while (r + h < rows &&
+                std::all_of(pending.data() + (r + h) * cols + c, pending.data() + (r + h) * cols + c + w, [](uint8_t f) { return f != 0; }))
+                ++h;
+
+            for (int rr = r; rr < r + h; ++rr)
+                std::fill_n(pending.data() + rr * cols + c, w, uint8_t(0));
+
+            merged.push_back({ minX + c * pitch + inset, minY + r * pitch + inset,
+                (w - 1) * pitch + size, (h - 1) * pitch + size });
+        }
+    }
+    return merged;
+}
+
+
+void LevelGeometry::build(const sf::Image& background, const SurfaceColours& colours) {
+    clear();
+    if (background.getSize().x == 0 || background.getSize().y == 0)
+        return;
+
+    // Classify the background once. Every sample below is at a multiple of
+    // the cell size, so the grid answers exactly what getPixel would.
+    terrain.build(background, [&colours](sf::Color c) { return colours.classify(c); }, TerrainCellSize);
+
+    auto blockPositions = findBlocks(static_cast<int>(background.getSize().x), static_cast<int>(background.getSize().y));
+    blockCount = blockPositions.size();
+
+    // Merge neighbouring blocks into as few rectangles as possible. The smaller
+    // collision box stays centred in each visual block, so a merged wall is
+    // CollisionSize thick and also spans the gaps between its blocks, which
+    // were always too narrow for the pug to fit through.
+    obstacles = mergeBlocks(blockPositions, StepSize, (BlockSize - CollisionSize) / 2, CollisionSize);
+    indexObstacles();
+
+    // burn them into the terrain, collision only ever asks the grid
+    for (size_t i = 0; i < obstacleGrid.size(); ++i)
+        terrain.fill(obstacleGrid.box(static_cast<uint32_t>(i)), Terrain::Wall);
+
+    wallField.build(terrain, Terrain::Wall);
+    spawns.build(terrain, Terrain::Track);
+}
+
+
+// Grass blocks around every track sample, beyond the margin. Bands of sample
+// rows are scanned in parallel, each into its own list; the lists are joined
+// in band order and sorted, which drops the duplicates found from
+// neighbouring track samples and makes the result the same whatever the
+// number of threads or the order the bands finished in.
+BlockPositions LevelGeometry::findBlocks(int width, int height) const {
+    auto scan = [this, width, height](int y, BlockPositions& out) {
+        for (int x = 0; x < width; x += StepSize) {
+            if (terrain.at(sf::Vector2f(x, y)) != Terrain::Track)
+                continue;
+
+            for (int dy = -BoundaryOffset; dy <= BoundaryOffset; dy += BlockSize) {
+                for (int dx = -BoundaryOffset; dx <= BoundaryOffset; dx += BlockSize) {
+                    int newX = x + dx;
+                    int newY = y + dy;
+                    if (newX < 0 || newX >= width || newY < 0 || newY >= height)
+                        continue;
+
+                    if (terrain.at(sf::Vector2f(newX, newY)) == Terrain::Grass &&
+                        std::sqrt(static_cast<float>(dx * dx + dy * dy)) > GrassMargin)
+                        out.emplace_back(newX, newY);
+                }
+            }
+        }
+        };
+
+    auto& pool = ThreadPool::getInstance();
+    size_t sampleRows = static_cast<size_t>((height + StepSize - 1) / StepSize);
+    size_t grain = pool.bandGrain(sampleRows);
+    std::vector<BlockPositions> bands((sampleRows + grain - 1) / grain);
+
+    pool.parallelFor(sampleRows, grain, [&](size_t first, size_t last) {
+        auto& out = bands[first / grain];
+        for (size_t r = first; r < last; ++r)
+            scan(static_cast<int>(r) * StepSize, out);
+        });
+
+    size_t total = 0;
+    for (const auto& band : bands)
+        total += band.size();
+
+    BlockPositions blocks;
+    blocks.reserve(total);
+    for (const auto& band : bands)
+        blocks.insert(blocks.end(), band.begin(), band.end());
+
+    std::sort(blocks.begin(), blocks.end());
+    blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
+    return blocks;
+}
+
+
+// obstacles never move, index them once so collision and render only visit nearby ones
+void LevelGeometry::indexObstacles() {
+    std::vector<sf::FloatRect> boxes;
+    boxes.reserve(obstacles.size());
+    for (const auto& obstacle : obstacles)
+        boxes.emplace_back(obstacle.x, obstacle.y, obstacle.width, obstacle.height);
+    obstacleGrid.build(boxes);
+}
+
+
+void LevelGeometry::clear() {
+    terrain = TerrainGrid();
+    wallField = DistanceField();
+    obstacleGrid.clear();
+    obstacles.clear();
+    blockCount = 0;
+    spawns.clear();
+}
+
+
+// The file is mapped, not read: hashing it touches each page once, and on a
+// hit that's all the image ever costs.
+LevelGeometry::Load LevelGeometry::loadOrBuild(const std::string& imagePath, const SurfaceColours& colours, const std::string& cachePath) {
+    MappedFile file;
+    if (!file.open(imagePath))
+        return Load::Failed;
+
+    auto key = cacheKey(file.data(), file.size(), colours);
+    if (loadCache(cachePath, key))
+        return Load::Cached;
+
+    sf::Image background;
+    if (!background.loadFromMemory(file.data(), file.size()))
+        return Load::Failed;
+
+    build(background, colours);
+    saveCache(cachePath, key);
+    return Load::Built;
+}
+
+
+LevelGeometry::Load LevelGeometry::loadOrBuild(const sf::Image& background, const SurfaceColours& colours, const std::string& cachePath) {
+    auto key = cacheKey(background, colours);
+    if (loadCache(cachePath, key))
+        return Load::Cached;
+
+    build(background, colours);
+    saveCache(cachePath, key);
+    return Load::Built;
+}
+
+
+// the encoded length goes in where the decoded size would, tagged so the two keys never meet
+uint64_t LevelGeometry::cacheKey(const std::byte* file, size_t size, const SurfaceColours& colours) {
+    auto h = mix(keyBase(colours), (uint64_t(1) << 63) | size);
+    return mixBytes(h, reinterpret_cast<const uint8_t*>(file), size);
+}
+
+
+uint64_t LevelGeometry::cacheKey(const sf::Image& background, const SurfaceColours& colours) {
+    auto size = background.getSize();
+    auto h = mix(keyBase(colours), (uint64_t(size.x) << 32) | size.y);
+
+    const auto* pixels = background.getPixelsPtr();
+    if (!pixels)
+        return h;
+    return mixBytes(h, pixels, size_t(size.x) * size.y * 4);
+}
+
+
+bool LevelGeometry::loadCache(const std::string& path, uint64_t key) {
+    MappedFile file;
+    if (!file.open(path))
+        return false;
+
+    ByteReader in(file.data(), file.size());
+    uint32_t magic{ 0 }, version{ 0 };
+    uint64_t fileKey{ 0 };
+    in.read(magic);
+    in.read(version);
+    in.read(fileKey);
+    if (!in.ok() || magic != CacheMagic || version != CacheVersion || fileKey != key)
+        return false;
+
+    clear();
+    bool ok = terrain.load(in) && wallField.load(in) && spawns.load(in);
+    in.read(blockCount);
+    in.readArray(obstacles);
+    if (!ok || !in.ok()) {
+        clear();
+        return false;
+    }
+
+    indexObstacles();
+    return true;
+}
+
+
+bool LevelGeometry::saveCache(const std::string& path, uint64_t key) const {
+    Snapshot out;
+    out.write(CacheMagic);
+    out.write(CacheVersion);
+    out.write(key);
+    terrain.save(out);
+    wallField.save(out);
+    spawns.save(out);
+    out.write(blockCount);
+    out.writeArray(obstacles);
+
+    std::error_code ec;
+    auto dir = std::filesystem::path(path).parent_path();
+    if (!dir.empty())
+        std::filesystem::create_directories(dir, ec);
+
+    // write next to it and swap in, so a crash mid-write can't leave a torn cache
+    auto tmp = path + ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        if (!file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size())))
+            return false;
+    }
+    std::filesystem::rename(tmp, path, ec);
+    return !ec;
+}
@@ -0,0 +1,93 @@
+#ifndef BREAKOUT_LEVELGEOMETRY_H
+#define BREAKOUT_LEVELGEOMETRY_H
+
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+#include <SFML/Graphics.hpp>
+
+#include "TerrainGrid.h"
+#include "DistanceField.h"
+#include "SpatialGrid.h"
+#include "SpawnTable.h"
+
+
+struct BlockingSquare {
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+
+// The colours a background paints its surfaces with, set per level. The
+// defaults are the park's.
+struct SurfaceColours {
+    sf::Color                   road{ 66, 80, 86 };
+    sf::Color                   grassMin{ 15, 210, 20 };    // grass is anything within
+    sf::Color                   grassMax{ 30, 230, 35 };    // [grassMin, grassMax] on every channel
+
+    Terrain                     classify(sf::Color c) const;
+    inline bool                 isRoad(sf::Color c) const { return c.r == road.r && c.g == road.g && c.b == road.b; }
+};
+
+using BlockPositions = std::vector<std::pair<int, int>>;   // top-left corners, sorted and unique
+
+// Greedy meshing of block positions laid out on a lattice of the given pitch,
+// see LevelGeometry.cpp.
+std::vector<BlockingSquare>     mergeBlocks(const BlockPositions& blocks, int pitch, int inset, int size);
+
+
+// The static collision of a level, all of it derived from the background
+// image: the terrain classes, the obstacles generated along the grass edge,
+// a grid over those obstacles and the distance field around them. Has no
+// dependency on the scene, so tools and benchmarks can build it headless.
+//
+// Building scans the whole image, so the result is cached on disk. The cache
+// file is keyed by a hash of the image file as stored, plus everything below
+// that shapes the result; a key that doesn't match means the cache is stale.
+// The hash is taken before decoding, so a hit never decodes the image.
+struct LevelGeometry {
+    enum class Load { Failed, Cached, Built };
+
+    static constexpr int        StepSize = 40;          // spacing of the track samples
+    static constexpr int        BlockSize = 40;         // visual block size
+    static constexpr int        CollisionSize = 16;     // collision box inside each block
+    static constexpr int        BoundaryOffset = 100;   // how far from a track sample to look for grass
+    static constexpr int        GrassMargin = 120;      // how much grass next to the track stays drivable
+    static constexpr unsigned   TerrainCellSize = 4;
+    static constexpr uint32_t   CacheVersion = 3;       // bump when the file layout or the generation changes
+
+    TerrainGrid                 terrain;        // track/grass/wall per cell, friction reads this
+    DistanceField               wallField;      // signed distance to the walls, collision reads this
+    SpatialGrid                 obstacleGrid;   // obstacles by position, item i is obstacles[i]
+    std::vector<BlockingSquare> obstacles;
+    size_t                      blockCount{ 0 };// blocks generated before merging
+    SpawnTable                  spawns;         // track cells clear of walls, for barrels and bones
+
+    void                        build(const sf::Image& background, const SurfaceColours& colours = {});
+    void                        clear();
+
+    // Loads cachePath if its key matches the image file and colours, else
+    // decodes the image, builds and rewrites the cache. Failed if the image
+    // can't be read or decoded. An unwritable cache only costs speed.
+    Load                        loadOrBuild(const std::string& imagePath, const SurfaceColours& colours, const std::string& cachePath);
+
+    // the same for an image that only exists decoded (a texture read back), keyed by its pixels
+    Load                        loadOrBuild(const sf::Image& background, const SurfaceColours& colours, const std::string& cachePath);
+
+    static uint64_t             cacheKey(const std::byte* file, size_t size, const SurfaceColours& colours);
+    static uint64_t             cacheKey(const sf::Image& background, const SurfaceColours& colours);
+    bool                        loadCache(const std::string& path, uint64_t key);
+    bool                        saveCache(const std::string& path, uint64_t key) const;
+
+private:
+    void                        indexObstacles();
+    BlockPositions              findBlocks(int width, int height) const;
+};
+
+
+#endif //BREAKOUT_LEVELGEOMETRY_H
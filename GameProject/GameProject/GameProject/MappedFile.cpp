@@ -0,0 +1,104 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    _file = file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        close();
+        return false;
+    }
+
+    _mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!_mapping) {
+        close();
+        return false;
+    }
+
+    _data = static_cast<const std::byte*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!_data) {
+        close();
+        return false;
+    }
+    _size = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+
+void MappedFile::close() {
+    if (_data)
+        UnmapViewOfFile(_data);
+    if (_mapping)
+        CloseHandle(_mapping);
+    if (_file)
+        CloseHandle(_file);
+
+    _data = nullptr;
+    _size = 0;
+    _mapping = nullptr;
+    _file = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+    _fd = ::open(path.c_str(), O_RDONLY);
+    if (_fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(_fd, &st) != 0 || st.st_size == 0) {
+        close();
+        return false;
+    }
+
+    void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, _fd, 0);
+    if (p == MAP_FAILED) {
+        close();
+        return false;
+    }
+    _data = static_cast<const std::byte*>(p);
+    _size = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+
+void MappedFile::close() {
+    if (_data)
+        munmap(const_cast<std::byte*>(_data), _size);
+    if (_fd >= 0)
+        ::close(_fd);
+
+    _data = nullptr;
+    _size = 0;
+    _fd = -1;
+}
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef BREAKOUT_MAPPEDFILE_H
+#define BREAKOUT_MAPPEDFILE_H
+
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+
+// Read-only view of a whole file mapped into memory. The pages are only read
+// from disk when touched, so opening is close to free whatever the size.
+class MappedFile {
+private:
+    const std::byte*    _data{ nullptr };
+    size_t              _size{ 0 };
+#ifdef _WIN32
+    void*               _file{ nullptr };
+    void*               _mapping{ nullptr };
+#else
+    int                 _fd{ -1 };
+#endif
+
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // false if the file is missing, empty or can't be mapped
+    bool                    open(const std::string& path);
+    void                    close();
+
+    inline const std::byte* data() const { return _data; }
+    inline size_t           size() const { return _size; }
+    inline bool             isOpen() const { return _data != nullptr; }
+};
+
+
+// Reads bytes written by Snapshot::write/writeArray back out of a mapped
+// file, in the same order. The file may be truncated or from an older build,
+// so running past the end doesn't assert: it zero-fills, and ok() turns false.
+class ByteReader {
+private:
+    const std::byte*    _cursor;
+    const std::byte*    _end;
+    bool                _ok{ true };
+
+    inline bool take(size_t n) {
+        if (!_ok || static_cast<size_t>(_end - _cursor) < n)
+            _ok = false;
+        return _ok;
+    }
+
+public:
+    ByteReader(const std::byte* data, size_t size) : _cursor(data), _end(data + size) {}
+
+    inline bool ok() const { return _ok; }
+
+
+    template<typename T>
+    inline void read(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (!take(sizeof(T))) {
+            value = T{};
+            return;
+        }
+        std::memcpy(&value, _cursor, sizeof(T));
+        _cursor += sizeof(T);
+    }
+
+
+    template<typename T>
+    inline void readArray(std::vector<T>& v) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        size_t n{ 0 };
+        read(n);
+        if (!_ok || n > static_cast<size_t>(_end - _cursor) / sizeof(T) || !take(n * sizeof(T))) {
+            _ok = false;
+            v.clear();
+            return;
+        }
+        v.resize(n);
+        if (n == 0)
+            return;
+
+        std::memcpy(v.data(), _cursor, n * sizeof(T));
+        _cursor += n * sizeof(T);
+    }
+};
+
+
+#endif //BREAKOUT_MAPPEDFILE_H
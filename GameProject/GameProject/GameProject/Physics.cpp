@@ -1,19 +1,28 @@
 #include "Physics.h"
 #include <cmath>
+#include <bit>
+#include <limits>
 
-sf::Vector2f Physics::getOverlap(std::shared_ptr<Entity> a, std::shared_ptr<Entity> b)
+#if defined(__AVX__)
+#include <immintrin.h>
+#define PHYSICS_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PHYSICS_SSE2
+#endif
+
+sf::Vector2f Physics::getOverlap(EntityPtr a, EntityPtr b)
 {
     sf::Vector2f overlap(0.f, 0.f);
     if (!a->hasComponent<CBoundingBox>() or !b->hasComponent<CBoundingBox>())
         return overlap;
 
-    auto atx = a->getComponent<CTransform>();
-    auto abb = a->getComponent<CBoundingBox>();
-    auto btx = b->getComponent<CTransform>();
-    auto bbb = b->getComponent<CBoundingBox>();
+    const auto& atx = a->getComponent<CTransform>();
+    const auto& abb = a->getComponent<CBoundingBox>();
+    const auto& btx = b->getComponent<CTransform>();
+    const auto& bbb = b->getComponent<CBoundingBox>();
 
 
-    if (abb.has && bbb.has)
     {
         float dx = std::abs(atx.pos.x - btx.pos.x);
         float dy = std::abs(atx.pos.y - btx.pos.y);
@@ -22,18 +31,17 @@ sf::Vector2f Physics::getOverlap(std::shared_ptr<Entity> a, std::shared_ptr<Enti
     return overlap;
 }
 
-sf::Vector2f Physics::getPreviousOverlap(std::shared_ptr<Entity> a, std::shared_ptr<Entity> b)
+sf::Vector2f Physics::getPreviousOverlap(EntityPtr a, EntityPtr b)
 {
     sf::Vector2f overlap(0.f, 0.f);
     if (!a->hasComponent<CBoundingBox>() or !b->hasComponent<CBoundingBox>())
         return overlap;
 
-    auto atx = a->getComponent<CTransform>();
-    auto abb = a->getComponent<CBoundingBox>();
-    auto btx = b->getComponent<CTransform>();
-    auto bbb = b->getComponent<CBoundingBox>();
+    const auto& atx = a->getComponent<CTransform>();
+    const auto& abb = a->getComponent<CBoundingBox>();
+    const auto& btx = b->getComponent<CTransform>();
+    const auto& bbb = b->getComponent<CBoundingBox>();
 
-    if (abb.has && bbb.has)
     {
         float dx = std::abs(atx.prevPos.x - btx.prevPos.x);
         float dy = std::abs(atx.prevPos.y - btx.prevPos.y);
@@ -41,3 +49,153 @@ sf::Vector2f Physics::getPreviousOverlap(std::shared_ptr<Entity> a, std::shared_
     }
     return overlap;
 }
+
+
+namespace {
+    // boxes [first, n) one at a time, out is already sized and its hits zeroed
+    inline void overlapScalar(sf::Vector2f c, sf::Vector2f h, const Physics::AABBs& b,
+        size_t first, size_t n, Physics::Overlaps& out)
+    {
+        for (size_t i = first; i < n; ++i) {
+            float ox = h.x + b.hx[i] - std::abs(c.x - b.cx[i]);
+            float oy = h.y + b.hy[i] - std::abs(c.y - b.cy[i]);
+            out.x[i] = ox;
+            out.y[i] = oy;
+            if (ox > 0.f && oy > 0.f)
+                out.hits[i / 64] |= uint64_t(1) << (i % 64);
+        }
+    }
+}
+
+
+size_t Physics::overlapBatch(sf::Vector2f centre, sf::Vector2f half, const AABBs& boxes, Overlaps& out)
+{
+    size_t n = boxes.size();
+    out.x.resize(n);
+    out.y.resize(n);
+    out.hits.assign((n + 63) / 64, 0);
+
+    size_t i = 0;
+
+#if defined(PHYSICS_AVX)
+    const __m256 cx = _mm256_set1_ps(centre.x), cy = _mm256_set1_ps(centre.y);
+    const __m256 hx = _mm256_set1_ps(half.x), hy = _mm256_set1_ps(half.y);
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 zero = _mm256_setzero_ps();
+
+    for (; i + 8 <= n; i += 8) {
+        __m256 dx = _mm256_and_ps(_mm256_sub_ps(cx, _mm256_loadu_ps(&boxes.cx[i])), absMask);
+        __m256 dy = _mm256_and_ps(_mm256_sub_ps(cy, _mm256_loadu_ps(&boxes.cy[i])), absMask);
+        __m256 ox = _mm256_sub_ps(_mm256_add_ps(hx, _mm256_loadu_ps(&boxes.hx[i])), dx);
+        __m256 oy = _mm256_sub_ps(_mm256_add_ps(hy, _mm256_loadu_ps(&boxes.hy[i])), dy);
+        _mm256_storeu_ps(&out.x[i], ox);
+        _mm256_storeu_ps(&out.y[i], oy);
+
+        __m256 hit = _mm256_and_ps(_mm256_cmp_ps(ox, zero, _CMP_GT_OQ), _mm256_cmp_ps(oy, zero, _CMP_GT_OQ));
+        out.hits[i / 64] |= uint64_t(_mm256_movemask_ps(hit)) << (i % 64);
+    }
+#elif defined(PHYSICS_SSE2)
+    const __m128 cx = _mm_set1_ps(centre.x), cy = _mm_set1_ps(centre.y);
+    const __m128 hx = _mm_set1_ps(half.x), hy = _mm_set1_ps(half.y);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 zero = _mm_setzero_ps();
+
+    for (; i + 4 <= n; i += 4) {
+        __m128 dx = _mm_and_ps(_mm_sub_ps(cx, _mm_loadu_ps(&boxes.cx[i])), absMask);
+        __m128 dy = _mm_and_ps(_mm_sub_ps(cy, _mm_loadu_ps(&boxes.cy[i])), absMask);
+        __m128 ox = _mm_sub_ps(_mm_add_ps(hx, _mm_loadu_ps(&boxes.hx[i])), dx);
+        __m128 oy = _mm_sub_ps(_mm_add_ps(hy, _mm_loadu_ps(&boxes.hy[i])), dy);
+        _mm_storeu_ps(&out.x[i], ox);
+        _mm_storeu_ps(&out.y[i], oy);
+
+        __m128 hit = _mm_and_ps(_mm_cmpgt_ps(ox, zero), _mm_cmpgt_ps(oy, zero));
+        out.hits[i / 64] |= uint64_t(_mm_movemask_ps(hit)) << (i % 64);
+    }
+#endif
+
+    // the tail, or everything without SIMD
+    overlapScalar(centre, half, boxes, i, n, out);
+
+    size_t count = 0;
+    for (auto word : out.hits)
+        count += std::popcount(word);
+    return count;
+}
+
+
+Physics::SweepHit Physics::sweep(sf::Vector2f centre, sf::Vector2f half, sf::Vector2f delta, const AABBs& boxes)
+{
+    constexpr float inf = std::numeric_limits<float>::infinity();
+    SweepHit best;
+
+    // Each box grown by half turns the mover into a point travelling along
+    // delta; intersect that ray with the grown box one axis (slab) at a time.
+    auto slab = [](float c, float d, float lo, float hi, float& entry, float& exit) {
+        if (d == 0.f) {
+            entry = -inf;
+            exit = inf;
+            return c > lo && c < hi;
+        }
+        float t1 = (lo - c) / d;
+        float t2 = (hi - c) / d;
+        entry = std::min(t1, t2);
+        exit = std::max(t1, t2);
+        return true;
+        };
+
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        float ex = half.x + boxes.hx[i];
+        float ey = half.y + boxes.hy[i];
+
+        float inX, outX, inY, outY;
+        if (!slab(centre.x, delta.x, boxes.cx[i] - ex, boxes.cx[i] + ex, inX, outX) ||
+            !slab(centre.y, delta.y, boxes.cy[i] - ey, boxes.cy[i] + ey, inY, outY))
+            continue;
+
+        float entry = std::max(inX, inY);
+        float exit = std::min(outX, outY);
+        if (entry >= exit || entry < 0.f || entry >= best.time)
+            continue;
+
+        best.time = entry;
+        best.index = i;
+        best.normal = (inX > inY)
+            ? sf::Vector2f(delta.x > 0.f ? -1.f : 1.f, 0.f)
+            : sf::Vector2f(0.f, delta.y > 0.f ? -1.f : 1.f);
+    }
+    return best;
+}
+
+
+bool Physics::resolveContact(EntityPtr a, EntityPtr b)
+{
+    auto overlap = getOverlap(a, b);
+    if (overlap.x <= 0.f || overlap.y <= 0.f)
+        return false;
+
+    float ia = a->hasComponent<CRigidBody>() ? a->getComponent<CRigidBody>().invMass : 0.f;
+    float ib = b->hasComponent<CRigidBody>() ? b->getComponent<CRigidBody>().invMass : 0.f;
+    if (ia + ib == 0.f)
+        return false;
+
+    auto& ta = a->getComponent<CTransform>();
+    auto& tb = b->getComponent<CTransform>();
+    sf::Vector2f normal = (overlap.x < overlap.y)   // from b towards a
+        ? sf::Vector2f(ta.pos.x < tb.pos.x ? -1.f : 1.f, 0.f)
+        : sf::Vector2f(0.f, ta.pos.y < tb.pos.y ? -1.f : 1.f);
+    float depth = std::min(overlap.x, overlap.y);
+    ta.pos += normal * (depth * ia / (ia + ib));
+    tb.pos -= normal * (depth * ib / (ia + ib));
+
+    sf::Vector2f rel = ta.vel - tb.vel;
+    float closing = -(rel.x * normal.x + rel.y * normal.y);
+    if (closing <= 0.f)
+        return false;
+
+    float e = std::min(ia > 0.f ? a->getComponent<CRigidBody>().restitution : 1.f,
+        ib > 0.f ? b->getComponent<CRigidBody>().restitution : 1.f);
+    float j = (1.f + e) * closing / (ia + ib);
+    ta.vel += normal * (j * ia);
+    tb.vel -= normal * (j * ib);
+    return true;
+}
@@ -7,6 +7,7 @@
 #include <SFML/Audio.hpp>
 
 #include <vector>
+#include <cstdint>
 #include <iostream>
 #include <memory>
 #include <fstream>
@@ -16,6 +17,65 @@
 
 namespace Physics
 {
-	sf::Vector2f getOverlap(std::shared_ptr<Entity> a, std::shared_ptr<Entity> b);
-	sf::Vector2f getPreviousOverlap(std::shared_ptr<Entity> a, std::shared_ptr<Entity> b);
+	sf::Vector2f getOverlap(EntityPtr a, EntityPtr b);
+	sf::Vector2f getPreviousOverlap(EntityPtr a, EntityPtr b);
+
+
+	// Boxes as parallel arrays (centre, half extents) so the batch kernels
+	// can load several at once. Refill per pass; clear() keeps the capacity.
+	struct AABBs
+	{
+		std::vector<float>	cx, cy;
+		std::vector<float>	hx, hy;
+
+		inline void clear() { cx.clear(); cy.clear(); hx.clear(); hy.clear(); }
+		inline void reserve(size_t n) { cx.reserve(n); cy.reserve(n); hx.reserve(n); hy.reserve(n); }
+		inline size_t size() const { return cx.size(); }
+
+		inline void push(sf::Vector2f centre, sf::Vector2f half) {
+			cx.push_back(centre.x);
+			cy.push_back(centre.y);
+			hx.push_back(half.x);
+			hy.push_back(half.y);
+		}
+	};
+
+
+	// Output of overlapBatch: overlap of the query with box i on each axis
+	// (positive on both means they intersect), and a bitset of the boxes hit,
+	// box i at bit i % 64 of hits[i / 64].
+	struct Overlaps
+	{
+		std::vector<float>		x, y;
+		std::vector<uint64_t>	hits;
+
+		inline bool hit(size_t i) const { return (hits[i / 64] >> (i % 64)) & 1u; }
+	};
+
+
+	// One box (centre, half) against every box in boxes, same maths as
+	// getOverlap. Uses AVX when compiled for it, else SSE2, else scalar, and
+	// returns how many boxes it hits.
+	size_t overlapBatch(sf::Vector2f centre, sf::Vector2f half, const AABBs& boxes, Overlaps& out);
+
+
+	struct SweepHit
+	{
+		float			time{ 1.f };			// fraction of delta travelled before contact, 1 if none
+		sf::Vector2f	normal{ 0.f, 0.f };		// face that was hit, pointing back at the mover
+		size_t			index{ SIZE_MAX };		// box that was hit
+	};
+
+
+	// Swept AABB: the earliest contact of box (centre, half) moving by delta
+	// with any of boxes. Boxes it already overlaps at the start are ignored,
+	// that is the static pass's job.
+	SweepHit sweep(sf::Vector2f centre, sf::Vector2f half, sf::Vector2f delta, const AABBs& boxes);
+
+
+	// Pushes two overlapping boxes apart along the shallower axis, shared in
+	// proportion to their inverse masses (no CRigidBody counts as immovable),
+	// then exchanges an impulse if they are closing. Returns true when the
+	// impulse was applied, so the caller can wake whichever of them can move.
+	bool resolveContact(EntityPtr a, EntityPtr b);
 };
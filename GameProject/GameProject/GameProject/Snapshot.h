@@ -0,0 +1,92 @@
+#ifndef BREAKOUT_SNAPSHOT_H
+#define BREAKOUT_SNAPSHOT_H
+
+
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <cassert>
+#include <type_traits>
+
+#include "ComponentStore.h"
+
+
+// Preallocated binary image of the world, written by EntityManager::save and
+// GameProject::saveSnapshot and read back in the same order by their restore
+// counterparts.
+//
+// Plain data is appended to one byte buffer with memcpy. Component types that
+// own resources (strings, textures) can't be copied as bytes, so each of
+// those gets its own typed shelf that is copy-assigned instead. clear() keeps
+// every capacity, so once a snapshot has been taken at the world's peak size,
+// taking it again every tick does not allocate.
+class Snapshot {
+private:
+    std::vector<std::byte>      _bytes;
+    size_t                      _cursor{ 0 };
+    Components::Shelves         _shelves;
+
+public:
+    inline void     clear() { _bytes.clear(); _cursor = 0; }
+    inline void     rewind() { _cursor = 0; }
+    inline void     reserve(size_t bytes) { _bytes.reserve(bytes); }
+    inline size_t   size() const { return _bytes.size(); }
+    inline bool     empty() const { return _bytes.empty(); }
+    inline const std::byte* data() const { return _bytes.data(); }
+
+
+    template<typename T>
+    inline void write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "write() copies bytes, use a shelf");
+        auto at = _bytes.size();
+        _bytes.resize(at + sizeof(T));
+        std::memcpy(_bytes.data() + at, &value, sizeof(T));
+    }
+
+
+    template<typename T>
+    inline void read(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "read() copies bytes, use a shelf");
+        assert(_cursor + sizeof(T) <= _bytes.size());
+        std::memcpy(&value, _bytes.data() + _cursor, sizeof(T));
+        _cursor += sizeof(T);
+    }
+
+
+    // element count followed by the raw elements
+    template<typename T>
+    inline void writeArray(const std::vector<T>& v) {
+        static_assert(std::is_trivially_copyable_v<T>, "writeArray() copies bytes, use a shelf");
+        write(v.size());
+        if (v.empty())
+            return;
+
+        auto at = _bytes.size();
+        _bytes.resize(at + v.size() * sizeof(T));
+        std::memcpy(_bytes.data() + at, v.data(), v.size() * sizeof(T));
+    }
+
+
+    template<typename T>
+    inline void readArray(std::vector<T>& v) {
+        static_assert(std::is_trivially_copyable_v<T>, "readArray() copies bytes, use a shelf");
+        size_t n{ 0 };
+        read(n);
+        assert(_cursor + n * sizeof(T) <= _bytes.size());
+        v.resize(n);
+        if (n == 0)
+            return;
+
+        std::memcpy(v.data(), _bytes.data() + _cursor, n * sizeof(T));
+        _cursor += n * sizeof(T);
+    }
+
+
+    template<typename T>
+    inline std::vector<T>& shelf() {
+        return std::get<std::vector<T>>(_shelves);
+    }
+};
+
+
+#endif //BREAKOUT_SNAPSHOT_H
@@ -0,0 +1,94 @@
+#include "SpatialGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+int SpatialGrid::col(float x) const {
+    return std::clamp(static_cast<int>(std::floor((x - _origin.x) / _cellSize)), 0, _cols - 1);
+}
+
+
+int SpatialGrid::row(float y) const {
+    return std::clamp(static_cast<int>(std::floor((y - _origin.y) / _cellSize)), 0, _rows - 1);
+}
+
+
+void SpatialGrid::build(const std::vector<sf::FloatRect>& boxes, float cellSize) {
+    clear();
+    if (boxes.empty())
+        return;
+
+    _boxes = boxes;
+    _cellSize = cellSize;
+
+    sf::Vector2f lo = { boxes[0].left, boxes[0].top };
+    sf::Vector2f hi = lo;
+    for (auto& b : boxes) {
+        lo.x = std::min(lo.x, b.left);
+        lo.y = std::min(lo.y, b.top);
+        hi.x = std::max(hi.x, b.left + b.width);
+        hi.y = std::max(hi.y, b.top + b.height);
+    }
+
+    _origin = lo;
+    _cols = static_cast<int>((hi.x - lo.x) / _cellSize) + 1;
+    _rows = static_cast<int>((hi.y - lo.y) / _cellSize) + 1;
+
+    auto forCells = [this](const sf::FloatRect& b, auto&& fn) {
+        for (int r = row(b.top), r1 = row(b.top + b.height); r <= r1; ++r)
+            for (int c = col(b.left), c1 = col(b.left + b.width); c <= c1; ++c)
+                fn(r * _cols + c);
+        };
+
+    // count per cell, prefix sum, then scatter
+    _cellStart.assign(static_cast<size_t>(_cols) * _rows + 1, 0);
+    for (auto& b : _boxes)
+        forCells(b, [this](int cell) { _cellStart[cell + 1]++; });
+
+    for (size_t c = 1; c < _cellStart.size(); ++c)
+        _cellStart[c] += _cellStart[c - 1];
+
+    _items.resize(_cellStart.back());
+    std::vector<uint32_t> fill(_cellStart.begin(), _cellStart.end() - 1);
+    for (uint32_t i = 0; i < _boxes.size(); ++i)
+        forCells(_boxes[i], [&](int cell) { _items[fill[cell]++] = i; });
+}
+
+
+void SpatialGrid::clear() {
+    _boxes.clear();
+    _cellStart.clear();
+    _items.clear();
+    _cols = _rows = 0;
+}
+
+
+void SpatialGrid::query(const sf::FloatRect& area, std::vector<uint32_t>& out) const {
+    if (_boxes.empty())
+        return;
+
+    float right = area.left + area.width;
+    float bottom = area.top + area.height;
+    if (right < _origin.x || bottom < _origin.y)
+        return;
+
+    int c0 = col(area.left), c1 = col(right);
+    int r0 = row(area.top), r1 = row(bottom);
+
+    auto first = out.size();
+    for (int r = r0; r <= r1; ++r) {
+        for (int c = c0; c <= c1; ++c) {
+            auto cell = r * _cols + c;
+            for (auto k = _cellStart[cell]; k < _cellStart[cell + 1]; ++k) {
+                auto i = _items[k];
+                if (_boxes[i].intersects(area))
+                    out.push_back(i);
+            }
+        }
+    }
+
+    // ascending item order, and each box once even if it spans several cells
+    std::sort(out.begin() + first, out.end());
+    out.erase(std::unique(out.begin() + first, out.end()), out.end());
+}
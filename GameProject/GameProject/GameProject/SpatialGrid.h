@@ -0,0 +1,48 @@
+#ifndef BREAKOUT_SPATIALGRID_H
+#define BREAKOUT_SPATIALGRID_H
+
+
+#include <vector>
+#include <cstdint>
+
+#include <SFML/Graphics.hpp>
+
+
+// Uniform grid over a fixed set of boxes, built once and queried many times.
+//
+// Each box is filed under every cell it overlaps, so long merged walls cost
+// a query nothing extra; a box seen from several cells is reported once.
+// Cells are stored flat (counting sort): the boxes of cell c are
+// _items[_cellStart[c] .. _cellStart[c + 1]).
+class SpatialGrid {
+private:
+    float                       _cellSize{ 64.f };
+    sf::Vector2f                _origin{ 0.f, 0.f };
+    int                         _cols{ 0 };
+    int                         _rows{ 0 };
+
+    std::vector<sf::FloatRect>  _boxes;                 // by item index
+    std::vector<uint32_t>       _cellStart;             // _cols * _rows + 1 offsets into _items
+    std::vector<uint32_t>       _items;                 // item indices grouped by cell
+
+    int                         col(float x) const;
+    int                         row(float y) const;
+
+public:
+    SpatialGrid() = default;
+
+    // replaces the contents, item i is boxes[i]
+    void                        build(const std::vector<sf::FloatRect>& boxes, float cellSize = 64.f);
+    void                        clear();
+
+    // Appends, in ascending order, the index of every box intersecting area.
+    // Read-only, so any number of threads may query at once.
+    void                        query(const sf::FloatRect& area, std::vector<uint32_t>& out) const;
+
+    inline const sf::FloatRect& box(uint32_t i) const { return _boxes[i]; }
+    inline size_t               size() const { return _boxes.size(); }
+    inline bool                 empty() const { return _boxes.empty(); }
+};
+
+
+#endif //BREAKOUT_SPATIALGRID_H
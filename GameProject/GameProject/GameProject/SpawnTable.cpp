@@ -0,0 +1,115 @@
+#include "SpawnTable.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+void SpawnTable::build(const TerrainGrid& terrain, Terrain spawnable) {
+    _cellSize = terrain.cellSize();
+    _cols = terrain.size().x;
+    _rows = terrain.size().y;
+    _cells.clear();
+
+    for (unsigned cy = 0; cy < _rows; ++cy)
+        for (unsigned cx = 0; cx < _cols; ++cx)
+            if (terrain.cell(cx, cy) == spawnable)
+                _cells.push_back(cy * _cols + cx);
+}
+
+
+void SpawnTable::clear() {
+    _cells.clear();
+    _cols = _rows = 0;
+}
+
+
+sf::Vector2f SpawnTable::position(size_t i) const {
+    auto cell = _cells[i];
+    return sf::Vector2f(static_cast<float>((cell % _cols) * _cellSize), static_cast<float>((cell / _cols) * _cellSize));
+}
+
+
+sf::Vector2f SpawnTable::pick(std::mt19937& rng) const {
+    std::uniform_int_distribution<size_t> index(0, _cells.size() - 1);
+    return position(index(rng));
+}
+
+
+void SpawnTable::sample(size_t n, float minDistance, std::mt19937& rng, std::vector<sf::Vector2f>& out) const {
+    if (_cells.empty() || n == 0)
+        return;
+
+    if (minDistance <= 0.f) {
+        for (size_t i = 0; i < n; ++i)
+            out.push_back(pick(rng));
+        return;
+    }
+
+    // Background grid with cells minDistance / sqrt(2) across, so each holds
+    // at most one point and a candidate only has to look two cells each way.
+    float cell = minDistance / std::sqrt(2.f);
+    int cols = static_cast<int>(_cols * _cellSize / cell) + 1;
+    int rows = static_cast<int>(_rows * _cellSize / cell) + 1;
+    auto& grid = _grid;             // index into out, -1 if empty
+    auto& crowded = _crowded;       // points already in out that found their grid cell taken
+    grid.assign(static_cast<size_t>(cols) * rows, -1);
+    crowded.clear();
+
+    auto cellOf = [&](sf::Vector2f p, int& c, int& r) {
+        c = std::clamp(static_cast<int>(p.x / cell), 0, cols - 1);
+        r = std::clamp(static_cast<int>(p.y / cell), 0, rows - 1);
+        };
+
+    auto near = [&](size_t i, sf::Vector2f p) {
+        sf::Vector2f d = out[i] - p;
+        return d.x * d.x + d.y * d.y < minDistance * minDistance;
+        };
+
+    auto fits = [&](sf::Vector2f p) {
+        for (auto i : crowded)
+            if (near(i, p))
+                return false;
+
+        int c, r;
+        cellOf(p, c, r);
+        for (int y = std::max(r - 2, 0); y <= std::min(r + 2, rows - 1); ++y) {
+            for (int x = std::max(c - 2, 0); x <= std::min(c + 2, cols - 1); ++x) {
+                auto other = grid[y * cols + x];
+                if (other >= 0 && near(static_cast<size_t>(other), p))
+                    return false;
+            }
+        }
+        return true;
+        };
+
+    auto place = [&](sf::Vector2f p) {
+        int c, r;
+        cellOf(p, c, r);
+        grid[r * cols + c] = static_cast<int32_t>(out.size());
+        out.push_back(p);
+        };
+
+    // points already there may be closer together than minDistance, only
+    // the new ones are held to it
+    for (size_t i = 0; i < out.size(); ++i) {
+        int c, r;
+        cellOf(out[i], c, r);
+        if (grid[r * cols + c] < 0)
+            grid[r * cols + c] = static_cast<int32_t>(i);
+        else
+            crowded.push_back(i);
+    }
+
+    constexpr size_t missesPerPoint = 30;
+    size_t placed = 0;
+    for (size_t misses = 0; placed < n && misses < missesPerPoint * n; ) {
+        auto p = pick(rng);
+        if (fits(p)) {
+            place(p);
+            ++placed;
+        }
+        else {
+            ++misses;
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef BREAKOUT_SPAWNTABLE_H
+#define BREAKOUT_SPAWNTABLE_H
+
+
+#include <vector>
+#include <random>
+#include <cstdint>
+
+#include <SFML/Graphics.hpp>
+
+#include "TerrainGrid.h"
+
+
+// Every place on a level where something may be spawned: the cells of one
+// terrain class in the level's TerrainGrid, read once after the walls are
+// burnt in so nothing spawns under one. Spawns go on the cell's top-left
+// corner.
+//
+// Drawing a spawn point is then one random index, however little of the
+// level is road, and the same rng state always gives the same points.
+class SpawnTable {
+private:
+    unsigned                _cellSize{ 4 };
+    unsigned                _cols{ 0 };
+    unsigned                _rows{ 0 };
+    std::vector<uint32_t>   _cells;         // spawnable cell indices, ascending
+
+    // sample() scratch, kept so sampling again doesn't allocate; it also
+    // means one table can't be sampled from two threads at once
+    mutable std::vector<int32_t>    _grid;
+    mutable std::vector<size_t>     _crowded;
+
+public:
+    SpawnTable() = default;
+
+    void                    build(const TerrainGrid& terrain, Terrain spawnable);
+    void                    clear();
+
+    sf::Vector2f            position(size_t i) const;
+
+    // one spawn point, uniform over the spawnable cells; the table must not be empty
+    sf::Vector2f            pick(std::mt19937& rng) const;
+
+    // Appends up to n points, each at least minDistance from every other point
+    // in out, including those already there (Poisson disk by dart throwing).
+    // Gives up after a bounded number of misses, so on a crowded level it may
+    // append fewer than n. minDistance 0 is plain pick() n times.
+    void                    sample(size_t n, float minDistance, std::mt19937& rng, std::vector<sf::Vector2f>& out) const;
+
+    inline size_t           size() const { return _cells.size(); }
+    inline bool             empty() const { return _cells.empty(); }
+    inline size_t           bytes() const { return _cells.size() * sizeof(uint32_t); }
+
+
+    // Archive is a Snapshot to save, a Snapshot or ByteReader to load.
+    template<typename Archive>
+    inline void save(Archive& ar) const {
+        ar.write(_cellSize);
+        ar.write(_cols);
+        ar.write(_rows);
+        ar.writeArray(_cells);
+    }
+
+
+    // false if what was read doesn't fit the grid it claims
+    template<typename Archive>
+    inline bool load(Archive& ar) {
+        ar.read(_cellSize);
+        ar.read(_cols);
+        ar.read(_rows);
+        ar.readArray(_cells);
+        if (_cellSize != 0 && (_cells.empty() || _cells.back() < static_cast<uint64_t>(_cols) * _rows))
+            return true;
+
+        clear();
+        return false;
+    }
+};
+
+
+#endif //BREAKOUT_SPAWNTABLE_H
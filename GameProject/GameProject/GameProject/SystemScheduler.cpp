@@ -0,0 +1,110 @@
+#include "SystemScheduler.h"
+#include "ThreadPool.h"
+#include "EntityManager.h"
+#include "EntityCommandBuffer.h"
+
+#include <thread>
+
+
+SystemScheduler::SystemScheduler(EntityManager& entityManager)
+    : _entityManager(entityManager) {}
+
+
+void SystemScheduler::add(const std::string& name, Signature reads, Signature writes, bool exclusive, SystemFn fn) {
+    _systems.push_back(System{ name, reads, writes, exclusive, std::move(fn) });
+    if (!exclusive)
+        _systems.back().commands = &_entityManager.createCommandBuffer();
+    _built = false;
+}
+
+
+bool SystemScheduler::conflicts(const System& a, const System& b) {
+    if (a.exclusive || b.exclusive)
+        return true;
+    return (a.writes & (b.reads | b.writes)) || (b.writes & a.reads);
+}
+
+
+// edges only point forward in registration order, so the graph is acyclic
+void SystemScheduler::build() {
+    for (auto& s : _systems) {
+        s.successors.clear();
+        s.dependencies = 0;
+    }
+
+    for (size_t j = 0; j < _systems.size(); ++j) {
+        for (size_t i = 0; i < j; ++i) {
+            if (conflicts(_systems[i], _systems[j])) {
+                _systems[i].successors.push_back(j);
+                _systems[j].dependencies++;
+            }
+        }
+    }
+
+    _waitingOn.reset(new std::atomic<int>[_systems.size()]);
+    _built = true;
+}
+
+
+void SystemScheduler::run(sf::Time dt) {
+    if (_systems.empty())
+        return;
+    if (!_built)
+        build();
+
+    _dt = dt;
+    _remaining = _systems.size();
+    for (size_t i = 0; i < _systems.size(); ++i)
+        _waitingOn[i] = _systems[i].dependencies;
+
+    for (size_t i = 0; i < _systems.size(); ++i)
+        if (_systems[i].dependencies == 0)
+            launch(i);
+
+    // run exclusive systems here and help the pool with the rest until the tick is done
+    auto& pool = ThreadPool::getInstance();
+    while (_remaining > 0) {
+        size_t next = _systems.size();
+        {
+            std::lock_guard<std::mutex> lock(_mainMutex);
+            if (!_mainQueue.empty()) {
+                next = _mainQueue.back();
+                _mainQueue.pop_back();
+            }
+        }
+
+        if (next < _systems.size()) {
+            execute(next);
+        }
+        else if (!pool.runPending()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+
+void SystemScheduler::launch(size_t i) {
+    if (_systems[i].exclusive) {
+        std::lock_guard<std::mutex> lock(_mainMutex);
+        _mainQueue.push_back(i);
+        return;
+    }
+
+    ThreadPool::getInstance().submit([this, i] { execute(i); });
+}
+
+
+void SystemScheduler::execute(size_t i) {
+    EntityCommandBuffer::bind(_systems[i].commands);
+    _systems[i].run(_dt);
+    EntityCommandBuffer::bind(nullptr);
+    finish(i);
+}
+
+
+void SystemScheduler::finish(size_t i) {
+    for (auto s : _systems[i].successors)
+        if (--_waitingOn[s] == 0)
+            launch(s);
+    --_remaining;
+}
@@ -0,0 +1,94 @@
+#ifndef BREAKOUT_SYSTEMSCHEDULER_H
+#define BREAKOUT_SYSTEMSCHEDULER_H
+
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <SFML/System.hpp>
+
+#include "ComponentStore.h"
+
+// forward declarations
+class EntityManager;
+class EntityCommandBuffer;
+
+
+// component access a system declares when it is registered
+template<typename... Ts>
+struct Reads {
+    static constexpr Signature mask = Components::maskOf<Ts...>();
+};
+
+template<typename... Ts>
+struct Writes {
+    static constexpr Signature mask = Components::maskOf<Ts...>();
+};
+
+
+// Runs the systems of one tick as a dependency graph on the ThreadPool.
+//
+// A system depends on every system registered before it that it conflicts
+// with: one writes a component the other reads or writes. Systems that don't
+// conflict run concurrently. Exclusive systems (structural changes, scene
+// state, audio) conflict with everything and always run on the thread that
+// called run(), so registration order is the serial order for them.
+//
+// Every non-exclusive system records into its own EntityCommandBuffer, bound
+// to its thread while it runs. Entity::destroy() and
+// EntityManager::commands() use that buffer, and the changes land at the
+// next EntityManager::update().
+class SystemScheduler {
+public:
+    using SystemFn = std::function<void(sf::Time)>;
+
+private:
+    struct System {
+        std::string             name;
+        Signature               reads{ 0 };
+        Signature               writes{ 0 };
+        bool                    exclusive{ false };
+        SystemFn                run;
+        EntityCommandBuffer*    commands{ nullptr };
+        std::vector<size_t>     successors;
+        int                     dependencies{ 0 };
+    };
+
+    EntityManager&                              _entityManager;
+    std::vector<System>                         _systems;
+    std::unique_ptr<std::atomic<int>[]>         _waitingOn;     // per system, dependencies still running this tick
+    std::atomic<size_t>                         _remaining{ 0 };
+    std::mutex                                  _mainMutex;
+    std::vector<size_t>                         _mainQueue;     // exclusive systems ready to run on the caller
+    sf::Time                                    _dt;
+    bool                                        _built{ false };
+
+    void        add(const std::string& name, Signature reads, Signature writes, bool exclusive, SystemFn fn);
+    void        build();
+    void        execute(size_t i);
+    void        launch(size_t i);
+    void        finish(size_t i);
+    static bool conflicts(const System& a, const System& b);
+
+public:
+    SystemScheduler(EntityManager& entityManager);
+
+    template<typename R, typename W>
+    inline void addSystem(const std::string& name, SystemFn fn) {
+        add(name, R::mask, W::mask, false, std::move(fn));
+    }
+
+
+    inline void addExclusive(const std::string& name, SystemFn fn) {
+        add(name, 0, 0, true, std::move(fn));
+    }
+
+
+    void        run(sf::Time dt);
+};
+
+
+#endif //BREAKOUT_SYSTEMSCHEDULER_H
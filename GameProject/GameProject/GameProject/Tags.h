@@ -0,0 +1,39 @@
+#ifndef BREAKOUT_TAGS_H
+#define BREAKOUT_TAGS_H
+
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+
+using TagId = uint16_t;
+
+
+// Tags known at compile time. EntityManager registers these first, in this
+// order, so Tags::Barrel etc. are valid TagIds without a string lookup.
+// Any other tag string is interned on first use and gets the next free id.
+namespace Tags
+{
+    enum : TagId {
+        Default,
+        Player,
+        Bkg,
+        Barrel,
+        Bone,
+        Explosion,
+        Count
+    };
+
+    inline constexpr std::array<std::string_view, Count> names{
+        "Default",
+        "player",
+        "bkg",
+        "Barrel",
+        "Bone",
+        "Explosion",
+    };
+};
+
+
+#endif //BREAKOUT_TAGS_H
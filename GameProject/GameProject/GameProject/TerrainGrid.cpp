@@ -0,0 +1,114 @@
+#include "TerrainGrid.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+    // cells [first, last] overlapping the open interval (lo, hi), false if none do
+    bool cellSpan(float lo, float hi, unsigned cellSize, unsigned count, unsigned& first, unsigned& last) {
+        float a = std::floor(lo / cellSize);
+        float b = std::ceil(hi / cellSize) - 1.f;
+        if (b < 0.f || a >= static_cast<float>(count) || b < a)
+            return false;
+
+        first = static_cast<unsigned>(std::max(a, 0.f));
+        last = static_cast<unsigned>(std::min(b, static_cast<float>(count - 1)));
+        return true;
+    }
+}
+
+
+void TerrainGrid::build(const sf::Image& image, const Classifier& classify, unsigned cellSize) {
+    _cellSize = cellSize;
+    _cols = (image.getSize().x + cellSize - 1) / cellSize;
+    _rows = (image.getSize().y + cellSize - 1) / cellSize;
+    _wordsPerRow = (_cols + CellsPerWord - 1) / CellsPerWord;
+    _bits.assign(static_cast<size_t>(_wordsPerRow) * _rows, 0);
+
+    const auto* pixels = image.getPixelsPtr();
+    if (!pixels)
+        return;
+
+    // Bands of rows in parallel. Every row starts on a fresh word, so no two
+    // bands ever write the same one.
+    size_t stride = static_cast<size_t>(image.getSize().x) * 4;
+    auto& pool = ThreadPool::getInstance();
+    pool.parallelFor(_rows, pool.bandGrain(_rows), [&](size_t first, size_t last) {
+        for (auto cy = static_cast<unsigned>(first); cy < last; ++cy) {
+            const auto* row = pixels + cy * cellSize * stride;
+            for (unsigned cx = 0; cx < _cols; ++cx) {
+                const auto* p = row + cx * cellSize * 4;
+                setCell(cx, cy, classify(sf::Color(p[0], p[1], p[2], p[3])));
+            }
+        }
+        });
+}
+
+
+Terrain TerrainGrid::cell(unsigned cx, unsigned cy) const {
+    if (cx >= _cols || cy >= _rows)
+        return Terrain::Open;
+
+    auto word = _bits[cy * _wordsPerRow + cx / CellsPerWord];
+    return static_cast<Terrain>((word >> (2 * (cx % CellsPerWord))) & 3u);
+}
+
+
+void TerrainGrid::setCell(unsigned cx, unsigned cy, Terrain t) {
+    if (cx >= _cols || cy >= _rows)
+        return;
+
+    auto& word = _bits[cy * _wordsPerRow + cx / CellsPerWord];
+    auto shift = 2 * (cx % CellsPerWord);
+    word = (word & ~(uint64_t(3) << shift)) | (uint64_t(t) << shift);
+}
+
+
+Terrain TerrainGrid::at(sf::Vector2f p) const {
+    if (p.x < 0.f || p.y < 0.f)
+        return Terrain::Open;
+
+    return cell(static_cast<unsigned>(p.x) / _cellSize, static_cast<unsigned>(p.y) / _cellSize);
+}
+
+
+void TerrainGrid::fill(const sf::FloatRect& area, Terrain t) {
+    unsigned cx0, cx1, cy0, cy1;
+    if (!cellSpan(area.left, area.left + area.width, _cellSize, _cols, cx0, cx1) ||
+        !cellSpan(area.top, area.top + area.height, _cellSize, _rows, cy0, cy1))
+        return;
+
+    for (auto cy = cy0; cy <= cy1; ++cy)
+        for (auto cx = cx0; cx <= cx1; ++cx)
+            setCell(cx, cy, t);
+}
+
+
+bool TerrainGrid::overlaps(const sf::FloatRect& area, Terrain t, sf::FloatRect& hit) const {
+    unsigned cx0, cx1, cy0, cy1;
+    if (!cellSpan(area.left, area.left + area.width, _cellSize, _cols, cx0, cx1) ||
+        !cellSpan(area.top, area.top + area.height, _cellSize, _rows, cy0, cy1))
+        return false;
+
+    unsigned minX = _cols, minY = _rows, maxX = 0, maxY = 0;
+    for (auto cy = cy0; cy <= cy1; ++cy) {
+        for (auto cx = cx0; cx <= cx1; ++cx) {
+            if (cell(cx, cy) != t)
+                continue;
+
+            minX = std::min(minX, cx);
+            maxX = std::max(maxX, cx);
+            minY = std::min(minY, cy);
+            maxY = std::max(maxY, cy);
+        }
+    }
+
+    if (minX > maxX || minY > maxY)
+        return false;
+
+    float cs = static_cast<float>(_cellSize);
+    hit = sf::FloatRect(minX * cs, minY * cs, (maxX - minX + 1) * cs, (maxY - minY + 1) * cs);
+    return true;
+}
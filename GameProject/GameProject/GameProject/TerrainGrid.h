@@ -0,0 +1,89 @@
+#ifndef BREAKOUT_TERRAINGRID_H
+#define BREAKOUT_TERRAINGRID_H
+
+
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+#include <SFML/Graphics.hpp>
+
+
+// what the ground is made of, two bits per cell
+enum class Terrain : uint8_t {
+    Open,
+    Track,
+    Grass,
+    Wall,
+};
+
+
+// Per-level terrain at a coarse resolution, packed 32 cells to a word.
+// Cell (cx, cy) covers world pixels [cx * cellSize, (cx + 1) * cellSize) and
+// takes the class of its top-left pixel, so lookups at multiples of
+// cellSize see exactly what the image has there. Anything outside the grid
+// is Open.
+class TerrainGrid {
+public:
+    using Classifier = std::function<Terrain(sf::Color)>;
+
+private:
+    static constexpr unsigned   CellsPerWord = 32;
+
+    unsigned                    _cellSize{ 4 };
+    unsigned                    _cols{ 0 };
+    unsigned                    _rows{ 0 };
+    unsigned                    _wordsPerRow{ 0 };
+    std::vector<uint64_t>       _bits;
+
+public:
+    TerrainGrid() = default;
+
+    void                        build(const sf::Image& image, const Classifier& classify, unsigned cellSize = 4);
+
+    Terrain                     cell(unsigned cx, unsigned cy) const;
+    void                        setCell(unsigned cx, unsigned cy, Terrain t);
+
+    // terrain under a world point
+    Terrain                     at(sf::Vector2f p) const;
+
+    // mark every cell touched by area
+    void                        fill(const sf::FloatRect& area, Terrain t);
+
+    // True if any cell of type t overlaps area; hit is then the bounding box
+    // of those cells. Cost depends on the size of area, not of the level.
+    bool                        overlaps(const sf::FloatRect& area, Terrain t, sf::FloatRect& hit) const;
+
+    inline unsigned             cellSize() const { return _cellSize; }
+    inline sf::Vector2u         size() const { return { _cols, _rows }; }
+    inline size_t               bytes() const { return _bits.size() * sizeof(uint64_t); }
+
+
+    // Archive is a Snapshot to save, a Snapshot or ByteReader to load.
+    template<typename Archive>
+    inline void save(Archive& ar) const {
+        ar.write(_cellSize);
+        ar.write(_cols);
+        ar.write(_rows);
+        ar.writeArray(_bits);
+    }
+
+
+    // false if what was read doesn't add up to a grid
+    template<typename Archive>
+    inline bool load(Archive& ar) {
+        ar.read(_cellSize);
+        ar.read(_cols);
+        ar.read(_rows);
+        ar.readArray(_bits);
+        _wordsPerRow = (_cols + CellsPerWord - 1) / CellsPerWord;
+        if (_cellSize != 0 && _bits.size() == static_cast<size_t>(_wordsPerRow) * _rows)
+            return true;
+
+        *this = TerrainGrid();
+        return false;
+    }
+};
+
+
+#endif //BREAKOUT_TERRAINGRID_H
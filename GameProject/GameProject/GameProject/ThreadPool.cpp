@@ -0,0 +1,147 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+
+namespace {
+    // index of the worker running on this thread, npos for everyone else
+    constexpr size_t npos = static_cast<size_t>(-1);
+    thread_local size_t tlsWorker = npos;
+}
+
+
+ThreadPool::ThreadPool() {
+    // leave one core for the main thread, it helps out while it waits anyway
+    size_t count = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+    for (size_t i = 0; i < std::max<size_t>(count, 1); ++i)
+        _queues.push_back(std::make_unique<Queue>());
+
+    for (size_t i = 0; i < count; ++i)
+        _workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _stop = true;
+    }
+    _wake.notify_all();
+    for (auto& w : _workers)
+        w.join();
+}
+
+
+ThreadPool& ThreadPool::getInstance() {
+    static ThreadPool instance;          // Meyers Singleton implementation
+    return instance;
+}
+
+
+void ThreadPool::submit(Task task) {
+    // workers keep their own follow-up work local, everyone else round-robins
+    size_t q = (tlsWorker != npos) ? tlsWorker : _nextQueue++ % _queues.size();
+    // count first so _queued never drops below the number of queued tasks
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        ++_queued;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_queues[q]->mutex);
+        _queues[q]->tasks.push_back(std::move(task));
+    }
+    _wake.notify_one();
+}
+
+
+bool ThreadPool::runPending() {
+    Task task;
+    size_t first = (tlsWorker != npos) ? tlsWorker : 0;
+    if (!popOrSteal(first, task))
+        return false;
+
+    task();
+    return true;
+}
+
+
+size_t ThreadPool::workerCount() const {
+    return _workers.size();
+}
+
+
+size_t ThreadPool::bandGrain(size_t count) const {
+    return std::max<size_t>(1, count / (4 * (_workers.size() + 1)));
+}
+
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn) {
+    grain = std::max<size_t>(grain, 1);
+    size_t chunks = (count + grain - 1) / grain;
+    if (chunks <= 1 || _workers.empty()) {
+        if (count > 0)
+            fn(0, count);
+        return;
+    }
+
+    std::atomic<size_t> remaining{ chunks };
+    for (size_t c = 1; c < chunks; ++c) {
+        submit([&, c] {
+            fn(c * grain, std::min(count, (c + 1) * grain));
+            --remaining;
+            });
+    }
+
+    fn(0, std::min(count, grain));
+    --remaining;
+    while (remaining > 0) {
+        if (!runPending())
+            std::this_thread::yield();
+    }
+}
+
+
+// own queue from the back (most recent, still warm in cache), others from the front
+bool ThreadPool::popOrSteal(size_t first, Task& task) {
+    if (_queued == 0)
+        return false;
+
+    for (size_t n = 0; n < _queues.size(); ++n) {
+        size_t q = (first + n) % _queues.size();
+        std::lock_guard<std::mutex> lock(_queues[q]->mutex);
+        auto& tasks = _queues[q]->tasks;
+        if (tasks.empty())
+            continue;
+
+        if (n == 0) {
+            task = std::move(tasks.back());
+            tasks.pop_back();
+        }
+        else {
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        --_queued;
+        return true;
+    }
+    return false;
+}
+
+
+void ThreadPool::workerLoop(size_t index) {
+    tlsWorker = index;
+
+    while (true) {
+        Task task;
+        if (popOrSteal(index, task)) {
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        _wake.wait(lock, [this] { return _stop || _queued > 0; });
+        if (_stop)
+            return;
+    }
+}
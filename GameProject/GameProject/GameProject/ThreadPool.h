@@ -0,0 +1,67 @@
+#ifndef BREAKOUT_THREADPOOL_H
+#define BREAKOUT_THREADPOOL_H
+
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+
+// Work-stealing pool. Every worker owns a deque: it pushes and pops its own
+// work at the back and, when that runs dry, steals from the front of the
+// others. Threads that are not workers (e.g. the main thread waiting on a
+// batch) can help out through runPending().
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+private:
+    ThreadPool();
+    ~ThreadPool();
+
+    struct Queue {
+        std::mutex          mutex;
+        std::deque<Task>    tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>>     _queues;        // one per worker
+    std::vector<std::thread>                _workers;
+    std::atomic<size_t>                     _queued{ 0 };
+    std::atomic<size_t>                     _nextQueue{ 0 };
+    std::atomic<bool>                       _stop{ false };
+    std::mutex                              _sleepMutex;
+    std::condition_variable                 _wake;
+
+    void        workerLoop(size_t index);
+    bool        popOrSteal(size_t first, Task& task);
+
+public:
+    static ThreadPool& getInstance();
+
+    // no copy/move for singleton
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+public:
+    void        submit(Task task);
+    bool        runPending();           // run one queued task on the calling thread, false if none
+    size_t      workerCount() const;
+
+    // Runs fn(begin, end) over [0, count) cut into chunks of at most grain,
+    // and returns once every chunk is done. The caller works through chunks
+    // too, so this is safe to call from a worker.
+    void        parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn);
+
+    // grain that cuts count rows into a few bands per thread, for balance
+    size_t      bandGrain(size_t count) const;
+};
+
+
+#endif //BREAKOUT_THREADPOOL_H